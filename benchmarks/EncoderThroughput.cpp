@@ -0,0 +1,68 @@
+// compares the text and the binary encoding of a work package
+// the subproblem has the layout of the TSP parameters, a path and the reduced N x N cost matrix,
+// which is the case where the text encoding hurts most
+#include <chrono>
+#include <random>
+#include "MPI_Message_Encoder.h"
+
+using Clock = std::chrono::steady_clock;
+using Params = std::tuple<std::vector<std::pair<int, int>>, std::vector<std::vector<int>>, int, int, int, int>;
+
+Params RandomSubproblem(int N) {
+    std::mt19937 mt(42);
+    std::uniform_int_distribution<int> dist(0, 100000);
+    Params p;
+    for (int i = 0; i < N / 2; i++)
+        std::get<0>(p).emplace_back(i, i + 1);
+    std::get<1>(p).assign(N, std::vector<int>(N));
+    for (auto &row : std::get<1>(p))
+        for (auto &el : row)
+            el = dist(mt);
+    std::get<2>(p) = 1234;
+    std::get<3>(p) = 5678;
+    std::get<4>(p) = 7;
+    std::get<5>(p) = 99999;
+    return p;
+}
+
+template<typename F>
+double Microseconds(int repetitions, F &&f) {
+    auto start = Clock::now();
+    for (int i = 0; i < repetitions; i++)
+        f();
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char *argv[]) {
+    int N = argc > 1 ? std::atoi(argv[1]) : 50;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    MPI_Message_Encoder<Params> encoder;
+    Params subproblem = RandomSubproblem(N);
+    Params decoded;
+
+    std::stringstream ss;
+    ss << std::setprecision(15);
+    size_t TextSize = 0;
+    double text = Microseconds(repetitions, [&]() {
+        ss.str("");
+        ss.clear();
+        encoder.Encode_Solution(ss, subproblem);
+        TextSize = ss.str().size();
+        encoder.Decode_Solution(ss, decoded);
+    });
+
+    MPI_Buffer buffer;
+    size_t BinarySize = 0;
+    double binary = Microseconds(repetitions, [&]() {
+        buffer.Clear();
+        encoder.Encode_Solution(buffer, subproblem);
+        BinarySize = buffer.Size();
+        buffer.Receive(buffer.Size());
+        encoder.Decode_Solution(buffer, decoded);
+    });
+
+    std::cout << "N=" << N << " text: " << text << " us, " << TextSize << " bytes"
+              << " | binary: " << binary << " us, " << BinarySize << " bytes" << std::endl;
+    return decoded == subproblem ? 0 : 1;
+}
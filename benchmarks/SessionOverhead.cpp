@@ -0,0 +1,71 @@
+// measures how much time a solve spends outside of the actual search
+// every instance is tiny so the time per solve is dominated by the setup of the solver,
+// once with a new solver per instance and once with a session that is reused for all instances.
+// A new Solver_MPI duplicates its communicator and its scheduler allocates windows, a node communicator and
+// persistent requests, a session does that once. Run it with mpirun, the times are those of process 0
+#include <chrono>
+#include "Knapsack.h"
+#include "Base.h"
+#include "BnB_MPI_Solver.h"
+#include "BnB_Session.h"
+
+using Clock = std::chrono::steady_clock;
+
+// the schedulers report to std::cout, this keeps them quiet while timing
+class Silence {
+public:
+    Silence() : old(std::cout.rdbuf(nullptr)) {}
+    ~Silence() { std::cout.rdbuf(old); }
+private:
+    std::streambuf *old;
+};
+
+template<typename F>
+double MicrosecondsPerSolve(int repetitions, F &&solve) {
+    Silence quiet;
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = Clock::now();
+    for (int i = 0; i < repetitions; i++)
+        solve(i);
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / repetitions;
+}
+
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 500;
+    int pid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &pid);
+
+    std::vector<BnB::Knapsack::Consts> instances;
+    for (int i = 0; i < 64; i++)
+        instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 42 + i));
+    auto Problem_Def = BnB::Knapsack::GenerateFasterProblem(true);
+
+    std::pair<BnB::MPI_Scheduler_Type, const char *> types[] = {{BnB::MPI_Scheduler_Type::PRIORITY,    "PRIORITY   "},
+                                                               {BnB::MPI_Scheduler_Type::WORKER_ONLY, "WORKER_ONLY"},
+                                                               {BnB::MPI_Scheduler_Type::ONESIDED,    "ONESIDED   "}};
+    for (auto [type, name] : types) {
+        double fresh = MicrosecondsPerSolve(repetitions, [&, type = type](int i) {
+            BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, float> solver;
+            solver.SetScheduler(type);
+            solver.SetSchedulerParameters()->Eps(0.001);
+            solver.Maximize(Problem_Def, instances[i % instances.size()]);
+        });
+
+        BnB::Session<BnB::Solver_MPI, BnB::Knapsack::Consts, BnB::Knapsack::Params, float> session(Problem_Def,
+                                                                                                   BnB::Goal::MAX);
+        session.GetSolver().SetScheduler(type);
+        session.GetSolver().SetSchedulerParameters()->Eps(0.001);
+        double reused = MicrosecondsPerSolve(repetitions, [&](int i) {
+            session.Solve(instances[i % instances.size()]);
+        });
+
+        if (pid == 0)
+            std::cout << name << " new solver per instance: " << fresh << " us/solve, "
+                      << "session: " << reused << " us/solve" << std::endl;
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -34,6 +34,7 @@ namespace BnB {
             const Problem_Consts &prob) {
         Goal goal = Goal::MAX;
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::lowest();
+        scheduler->Control(this->control);
         return scheduler->Execute(Problem_Def, prob, goal, WorstSolution);
     }
 
@@ -43,6 +44,7 @@ namespace BnB {
             const Problem_Consts &prob) {
         Goal goal = Goal::MIN;
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::max();
+        scheduler->Control(this->control);
         return scheduler->Execute(Problem_Def, prob, goal, WorstSolution);
     }
 }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Base.h"
+#include "BnB_Solver.h"
+
+namespace BnB {
+    // keeps a solver and everything it allocated alive between solves, meant for solving many
+    // instances of the same problem one after another. The problem definition is copied once.
+    // A Solver_MPI keeps its duplicated communicator, and its scheduler keeps the MPI windows, the node
+    // communicator, the persistent requests and the message buffers, so small instances are solved much faster
+    // than with a new solver for each (benchmarks/SessionOverhead). The OpenMP runtime keeps its
+    // threads anyway, for the shared memory solvers a session only keeps the configuration.
+    // Solver_Type -- one of Solver_Serial, Solver_OMP, Solver_MPI, Solver_Portfolio
+    template<template<typename, typename, typename> class Solver_Type,
+            typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    class Session {
+    public:
+        Session(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                Goal goal) : Problem_Def(Problem_Def), goal(goal) {}
+
+        // the solver can be configured like a standalone one, settings stay for all following solves
+        Solver_Type<Problem_Consts, Subproblem_Params, Domain_Type> &GetSolver() { return solver; }
+
+        // solves one instance, the constants only have to live until the call returns
+        Subproblem_Params Solve(const Problem_Consts &prob) {
+            NumSolves++;
+            if (goal == Goal::MAX)
+                return solver.Maximize(Problem_Def, prob);
+            else
+                return solver.Minimize(Problem_Def, prob);
+        }
+
+        // number of instances solved by this session
+        size_t SolveCount() const { return NumSolves; }
+
+    private:
+        Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> Problem_Def;
+        Goal goal;
+        Solver_Type<Problem_Consts, Subproblem_Params, Domain_Type> solver;
+        size_t NumSolves = 0;
+    };
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "Search_Control.h"
+
 namespace BnB{
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     class Solver {
     public:
+        virtual ~Solver() = default;
+
         // maximizes a problem defined by the user
         virtual Subproblem_Params
         Maximize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type>&, const Problem_Consts &) = 0;
@@ -11,6 +15,27 @@ namespace BnB{
         // minimizes a problem defined by the user
         virtual Subproblem_Params
         Minimize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type>& , const Problem_Consts &) = 0;
+
+        // all following searches report to and can be stopped through this control
+        void AttachControl(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> c) { control = std::move(c); }
+
+        // starts the search in the background and returns immediately, the definition and constants are copied
+        // the solver has to outlive the handle and must not be used for anything else until the search ended
+        Solve_Handle<Subproblem_Params, Domain_Type>
+        SolveAsync(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type>& Problem_Def,
+                   const Problem_Consts &prob, Goal goal) {
+            AttachControl(std::make_shared<Search_Control<Subproblem_Params, Domain_Type>>());
+            uint64_t Search = control->SearchId();
+            auto result = std::async(std::launch::async, [this, Problem_Def, prob, goal]() {
+                return goal == Goal::MAX ? this->Maximize(Problem_Def, prob) : this->Minimize(Problem_Def, prob);
+            });
+            return Solve_Handle<Subproblem_Params, Domain_Type>(control, std::move(result), Search);
+        }
+
+    protected:
+        // handed to the scheduler before every search
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control =
+                std::make_shared<Search_Control<Subproblem_Params, Domain_Type>>();
     };
 
 }
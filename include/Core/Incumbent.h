@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include "Base.h"
+
+namespace BnB {
+    // best solution found so far, can be read and improved by several threads at once
+    // the bound is atomic so that pruning never has to take a lock, the solution itself is
+    // only touched when the bound improves which is rare
+    template<typename Subproblem_Params, typename Domain_Type>
+    class Atomic_Incumbent {
+    public:
+        // forget everything, WorstBound is the value every solution is better than
+        void Reset(Goal g, Domain_Type WorstBound) {
+            std::lock_guard<std::mutex> guard(SolutionLock);
+            goal = g;
+            SolutionBound = WorstBound;
+            BestSolution = Subproblem_Params();
+            BestBound.store(WorstBound);
+        }
+
+        Domain_Type Bound() const { return BestBound.load(std::memory_order_relaxed); }
+
+        // true if a subproblem with this estimate can not beat the incumbent
+        bool IsPruned(Domain_Type Estimate) const {
+            Domain_Type Bound = BestBound.load(std::memory_order_relaxed);
+            return ((bool) goal && Estimate < Bound) || (!(bool) goal && Estimate > Bound);
+        }
+
+        // offers a solution with its contained bound, returns true if it became the incumbent
+        bool Offer(Domain_Type CandidateBound, const Subproblem_Params &Candidate) {
+            if (IsWorse(CandidateBound, BestBound.load(std::memory_order_relaxed)))
+                return false;
+            std::lock_guard<std::mutex> guard(SolutionLock);
+            if (IsWorse(CandidateBound, SolutionBound))
+                return false;
+            SolutionBound = CandidateBound;
+            BestSolution = Candidate;
+            // a bound offered without solution may already be better, never make the bound worse
+            OfferBound(CandidateBound);
+            return true;
+        }
+
+        // a bound that was achieved somewhere else, only the bound improves the solution stays
+        bool OfferBound(Domain_Type CandidateBound) {
+            Domain_Type Bound = BestBound.load(std::memory_order_relaxed);
+            while (!IsWorse(CandidateBound, Bound) && CandidateBound != Bound) {
+                if (BestBound.compare_exchange_weak(Bound, CandidateBound))
+                    return true;
+            }
+            return false;
+        }
+
+        Subproblem_Params Solution() const {
+            std::lock_guard<std::mutex> guard(SolutionLock);
+            return BestSolution;
+        }
+
+    private:
+        // ties count as improvement like in all schedulers
+        bool IsWorse(Domain_Type Candidate, Domain_Type Bound) const {
+            return ((bool) goal && Candidate < Bound) || (!(bool) goal && Candidate > Bound);
+        }
+
+        Goal goal = Goal::MAX;
+        std::atomic<Domain_Type> BestBound{};
+        // bound that belongs to BestSolution, guarded by SolutionLock
+        Domain_Type SolutionBound{};
+        Subproblem_Params BestSolution;
+        mutable std::mutex SolutionLock;
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <future>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+#include "Base.h"
+#include "Incumbent.h"
+
+namespace BnB {
+    // shared between a running search and whoever started it
+    // the schedulers report every improvement here and check IsCancelled in their inner loops,
+    // the caller can watch the progress and stop the search from any thread
+    template<typename Subproblem_Params, typename Domain_Type>
+    class Search_Control {
+    public:
+        // gets the new incumbent bound, called from the thread that found it
+        using Improvement_Callback = std::function<void(Domain_Type Bound)>;
+
+        // number of the running search, or of the next one if none is running
+        uint64_t SearchId() const { return Generation.load(); }
+
+        // asks the running search, or the next one if none is running, to stop. It returns the best solution
+        // found until then
+        void Cancel() { Cancel(SearchId()); }
+
+        // only stops the search with this number, a cancel that comes after it ended does nothing
+        void Cancel(uint64_t Search) { CancelledSearch.store(Search); }
+
+        // two relaxed atomic loads, cheap enough for every node
+        bool IsCancelled() const {
+            return CancelledSearch.load(std::memory_order_relaxed) == Generation.load(std::memory_order_relaxed);
+        }
+
+        void OnImprovement(Improvement_Callback cb) {
+            std::lock_guard<std::mutex> guard(CallbackLock);
+            callback = std::move(cb);
+        }
+
+        // called by the schedulers when a search starts, a cancel made before it still stops it
+        void Start(Goal g, Domain_Type WorstBound, Domain_Type RootEstimate) {
+            Worst.store(WorstBound);
+            Root.store(RootEstimate);
+            incumbent.Reset(g, WorstBound);
+        }
+
+        // called by the schedulers when a search has ended, later cancels belong to the next search
+        void Finish() { Generation++; }
+
+        // a solution with its contained bound was found on this process
+        void Improved(Domain_Type Bound, const Subproblem_Params &Solution) {
+            Domain_Type before = incumbent.Bound();
+            if (incumbent.Offer(Bound, Solution) && Bound != before)
+                Notify(Bound);
+        }
+
+        // a bound was found somewhere else (e.g. on another process) and only its value is known here
+        void BoundImproved(Domain_Type Bound) {
+            if (incumbent.OfferBound(Bound))
+                Notify(Bound);
+        }
+
+        Domain_Type Incumbent() const { return incumbent.Bound(); }
+
+        // best solution found on this process
+        Subproblem_Params Solution() const { return incumbent.Solution(); }
+
+        bool HasIncumbent() const { return incumbent.Bound() != Worst.load(); }
+
+        // relative distance between the incumbent and the estimate of the root. The estimate is taken once before
+        // the search, so this is an a priori bound: the true gap is never bigger, but it only shrinks through a
+        // better incumbent and not while the open subproblems get closed. Infinite as long as there is no incumbent
+        double RootGap() const {
+            if (!HasIncumbent()) return std::numeric_limits<double>::infinity();
+            double value = incumbent.Bound();
+            return std::abs(static_cast<double>(Root.load()) - value) / std::max(std::abs(value), 1e-10);
+        }
+
+    private:
+        void Notify(Domain_Type Bound) {
+            std::lock_guard<std::mutex> guard(CallbackLock);
+            if (callback) callback(Bound);
+        }
+
+        std::atomic<uint64_t> Generation{0};
+        // no search has this number until the first cancel
+        std::atomic<uint64_t> CancelledSearch{std::numeric_limits<uint64_t>::max()};
+        std::atomic<Domain_Type> Worst{};
+        std::atomic<Domain_Type> Root{};
+        Atomic_Incumbent<Subproblem_Params, Domain_Type> incumbent;
+        std::mutex CallbackLock;
+        Improvement_Callback callback = nullptr;
+    };
+
+
+    // returned by Solver::SolveAsync, gives access to a search that runs in the background
+    // it belongs to that one search, a cancel after it ended does not touch the next search of the solver
+    template<typename Subproblem_Params, typename Domain_Type>
+    class Solve_Handle {
+    public:
+        // Search is the SearchId of the control taken before the search was started
+        Solve_Handle(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control,
+                     std::future<Subproblem_Params> result, uint64_t Search)
+                : control(std::move(control)), result(std::move(result)), Search(Search) {}
+
+        bool IsDone() const {
+            return !result.valid() || result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // blocks until the search has ended and returns its solution, can only be called once
+        Subproblem_Params Get() { return result.get(); }
+
+        void Cancel() { control->Cancel(Search); }
+
+        Domain_Type Incumbent() const { return control->Incumbent(); }
+
+        Subproblem_Params Solution() const { return control->Solution(); }
+
+        double RootGap() const { return control->RootGap(); }
+
+        void OnImprovement(typename Search_Control<Subproblem_Params, Domain_Type>::Improvement_Callback cb) {
+            control->OnImprovement(std::move(cb));
+        }
+
+    private:
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control;
+        std::future<Subproblem_Params> result;
+        uint64_t Search;
+    };
+}
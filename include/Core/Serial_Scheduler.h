@@ -1,12 +1,15 @@
 #pragma once
 
 #include "Base.h"
+#include "Search_Control.h"
 
 namespace BnB{
     // strategy pattern that holds the branch-and-bound procedure
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
     class Serial_Scheduler {
     public:
+        virtual ~Serial_Scheduler() = default;
+
         virtual Subproblem_Params
         Execute(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                 const Prob_Consts &prob,
@@ -15,9 +18,13 @@ namespace BnB{
 
         Serial_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *Eps(Domain_Type e) {EPS = e; return this;}
         Serial_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *TraversMode(TraversalMode m) {mode = m; return this;};
+        // the search reports its progress to this control and stops once it is cancelled
+        Serial_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *Control(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> c) {control = std::move(c); return this;}
 
     protected:
         double EPS = 0.001;
         TraversalMode mode = TraversalMode::DFS;
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control =
+                std::make_shared<Search_Control<Subproblem_Params, Domain_Type>>();
     };
 }
\ No newline at end of file
@@ -21,13 +21,15 @@ namespace BnB {
 
         std::deque<Subproblem_Params> TaskQueue;
         TaskQueue.push_back(Problem_Def.GetInitialSubproblem(prob));
+        this->control->Start(goal, WorstBound, std::get<0>(Problem_Def.GetEstimateForBounds(prob, TaskQueue.front())));
 
         Domain_Type BestBound = WorstBound;
         Subproblem_Params BestSubproblem;
         int NumProblemsSolved = 0;
         int ProblemsEliminated = 0;
 
-        while (!TaskQueue.empty()) {
+        // a cancelled search keeps the best solution found so far
+        while (!TaskQueue.empty() && !this->control->IsCancelled()) {
             NumProblemsSolved++;
 
             Subproblem_Params sol = GetNextSubproblem(TaskQueue, this->mode);
@@ -62,12 +64,15 @@ namespace BnB {
                 v = Problem_Def.SplitSolution(prob, sol);
                 std::move(std::begin(v), std::end(v), std::back_inserter(TaskQueue));
             }
-            if (IsPotentialBestSolution)
+            if (IsPotentialBestSolution) {
                 BestSubproblem = sol;
+                this->control->Improved(BestBound, sol);
+            }
         }
 
         std::cout << "I have solved " << NumProblemsSolved << " problems" << std::endl;
         std::cout << "and eliminated " << ProblemsEliminated << " problems" << std::endl;
+        this->control->Finish();
         Problem_Def.PrintSolution(BestSubproblem);
         return BestSubproblem;
     }
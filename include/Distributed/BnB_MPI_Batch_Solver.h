@@ -0,0 +1,156 @@
+#pragma once
+#include "Base.h"
+#include "MPI_Scheduler.h"
+#include "BnB_Batch_Solver.h"
+
+namespace BnB {
+    namespace Batch { // messages used by the distributed batch solver
+        enum MessageType {
+            REQUEST = 20, WORK = 21, RESULTS = 22,
+        };
+    }
+
+    // distributes many independent instances over all processes, every process has to hold the whole
+    // range of instances (as it does when every rank reads the same file).
+    // Process 0 hands out chunks of instance indices on request so that fast processes get more chunks,
+    // every process solves its chunks with a Solver_Batch (so with all its threads) and the others send the
+    // solutions back. Process 0 only takes a chunk when no request is waiting, requests that arrive meanwhile
+    // wait until its chunk is solved. The callback is only called on process 0, in the order the chunks complete.
+    // Like Solver_MPI it only uses its own duplicate of the communicator given to the constructor
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    class Solver_MPI_Batch {
+    public:
+        using Result_Callback = typename Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type>::Result_Callback;
+
+        explicit Solver_MPI_Batch(MPI_Comm communicator = MPI_COMM_WORLD) { MPI_Comm_dup(communicator, &comm); }
+        ~Solver_MPI_Batch() {
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized) MPI_Comm_free(&comm);
+        }
+        Solver_MPI_Batch(const Solver_MPI_Batch &) = delete;
+        Solver_MPI_Batch &operator=(const Solver_MPI_Batch &) = delete;
+
+        // threads per process
+        void SetNumThreads(int num) { LocalSolver.SetNumThreads(num); }
+
+        // number of instances given out per request, bigger chunks mean less messages but worse balance
+        Solver_MPI_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *ChunkSize(int size) {
+            Chunk = size;
+            return this;
+        }
+
+        // the local solver exposes the large instance threshold and the scheduler parameters
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> &GetLocalSolver() { return LocalSolver; }
+
+        template<typename RandomIt>
+        void Maximize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                      RandomIt first, RandomIt last, const Result_Callback &callback) {
+            Solve(Problem_Def, first, last, Goal::MAX, callback);
+        }
+
+        template<typename RandomIt>
+        void Minimize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                      RandomIt first, RandomIt last, const Result_Callback &callback) {
+            Solve(Problem_Def, first, last, Goal::MIN, callback);
+        }
+
+    private:
+        template<typename RandomIt>
+        void Solve(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                   RandomIt first, RandomIt last, Goal goal, const Result_Callback &callback);
+
+        MPI_Comm comm = MPI_COMM_NULL;
+        int Chunk = 1;
+        MPI_Message_Encoder<Subproblem_Params> encoder;
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> LocalSolver;
+    };
+
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    template<typename RandomIt>
+    void Solver_MPI_Batch<Problem_Consts, Subproblem_Params, Domain_Type>::Solve(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            RandomIt first, RandomIt last, Goal goal, const Result_Callback &callback) {
+        int pid, num;
+        MPI_Comm_rank(comm, &pid);
+        MPI_Comm_size(comm, &num);
+        long NumInstances = std::distance(first, last);
+
+        // a single process has nobody to distribute to
+        if (num == 1) {
+            if (goal == Goal::MAX) LocalSolver.Maximize(Problem_Def, first, last, callback);
+            else LocalSolver.Minimize(Problem_Def, first, last, callback);
+            return;
+        }
+
+        MPI_Buffer buffer;
+        MPI_Status st;
+
+        if (pid == 0) {
+            long next = 0;
+            int FinishedWorkers = 0;
+            while (FinishedWorkers != num - 1) {
+                int pending = 0;
+                if (next < NumInstances)
+                    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &pending, &st);
+                if (next < NumInstances && !pending) {
+                    long start = next;
+                    next += std::min<long>(Chunk, NumInstances - next);
+                    auto report = [&callback, start](size_t index, const Subproblem_Params &Solution) {
+                        callback(start + index, Solution);
+                    };
+                    if (goal == Goal::MAX)
+                        LocalSolver.Maximize(Problem_Def, first + start, first + next, report);
+                    else
+                        LocalSolver.Minimize(Problem_Def, first + start, first + next, report);
+                    continue;
+                }
+
+                ReceiveMessage(buffer, MPI_ANY_SOURCE, MPI_ANY_TAG, st, comm);
+
+                if (st.MPI_TAG == Batch::MessageType::REQUEST) {
+                    long range[2] = {next, std::min<long>(Chunk, NumInstances - next)};
+                    next += range[1];
+                    if (range[1] == 0) FinishedWorkers++;
+                    MPI_Send(range, 2, MPI_LONG, st.MPI_SOURCE, Batch::MessageType::WORK, comm);
+                } else if (st.MPI_TAG == Batch::MessageType::RESULTS) {
+                    int NumResults;
+                    buffer.Read(NumResults);
+                    for (int i = 0; i < NumResults; i++) {
+                        size_t index;
+                        Subproblem_Params Solution;
+                        buffer.Read(index);
+                        encoder.Decode_Solution(buffer, Solution);
+                        callback(index, Solution);
+                    }
+                }
+            }
+        } else {
+            std::vector<std::pair<size_t, Subproblem_Params>> Results;
+            while (true) {
+                MPI_Send(nullptr, 0, MPI_CHAR, 0, Batch::MessageType::REQUEST, comm);
+                long range[2];
+                MPI_Recv(range, 2, MPI_LONG, 0, Batch::MessageType::WORK, comm, &st);
+                if (range[1] == 0) break;
+
+                Results.clear();
+                auto collect = [&Results, &range](size_t index, const Subproblem_Params &Solution) {
+                    Results.emplace_back(range[0] + index, Solution);
+                };
+                if (goal == Goal::MAX)
+                    LocalSolver.Maximize(Problem_Def, first + range[0], first + range[0] + range[1], collect);
+                else
+                    LocalSolver.Minimize(Problem_Def, first + range[0], first + range[0] + range[1], collect);
+
+                buffer.Clear();
+                buffer.Write(static_cast<int>(Results.size()));
+                for (const auto &result : Results) {
+                    buffer.Write(result.first);
+                    encoder.Encode_Solution(buffer, result.second);
+                }
+                MPI_Send(buffer.Data(), buffer.Size(), MPI_CHAR, 0, Batch::MessageType::RESULTS, comm);
+            }
+        }
+    }
+}
@@ -1,42 +1,79 @@
 #pragma once
 #include "MPI_Message_Encoder.h"
 #include "MPI_Scheduler_MasterWorker.h"
+#include "MPI_Scheduler_Hierarchical.h"
 #include "MPI_Scheduler_Hybrid.h"
 #include "MPI_Scheduler_WorkerOnly.h"
+#include "MPI_Scheduler_OneSided.h"
 #include "BnB_Solver.h"
 #include "Base.h"
 
 namespace BnB{
 
-    enum class MPI_Scheduler_Type{PRIORITY, HYBRID, ONESIDED,};
+    // ONESIDED steals work through MPI windows, WORKER_ONLY steals through messages,
+    // HIERARCHICAL is PRIORITY with sub-masters that serve groups of workers
+    enum class MPI_Scheduler_Type{PRIORITY, HYBRID, ONESIDED, WORKER_ONLY, HIERARCHICAL,};
 
     // main solver class has to be initiated by the user
     // Problem_Consts    -- should be an std::tuple holding constants of the problem
     // Subproblem_Params -- should be an std::tuple holding values that describe the problem
     // Domain_Type       -- one of the following : double, float, int
+    // SolveAsync runs the search on another thread, MPI has to be initialized with at least MPI_THREAD_SERIALIZED
+    // for that and the calling thread must not use MPI until the search ended.
+    // The solver searches on its own duplicate of the communicator given to the constructor, so only its
+    // processes have to call Maximize and Minimize and its messages never mix with those of the application
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     class Solver_MPI : public Solver<Problem_Consts, Subproblem_Params, Domain_Type>
     {
     public:
+        explicit Solver_MPI(MPI_Comm communicator = MPI_COMM_WORLD) {MPI_Comm_dup(communicator, &comm);}
+        ~Solver_MPI() override;
+        Solver_MPI(const Solver_MPI&) = delete;
+        Solver_MPI& operator=(const Solver_MPI&) = delete;
 
         // maximizes a problem defines by the user
         Subproblem_Params Maximize(const Problem_Definition<Problem_Consts, Subproblem_Params, Domain_Type>&, const Problem_Consts&);
         // minimizes a problem defined by the user
         Subproblem_Params Minimize(const Problem_Definition<Problem_Consts, Subproblem_Params, Domain_Type>&, const Problem_Consts&);
-        // if not called default scheduler will be used
+        // if not called default scheduler will be used, has to be called by all processes as the old scheduler
+        // frees the windows it kept between solves
         void SetScheduler(MPI_Scheduler_Type Scheduler);
         // return instance of scheduler who exposes his parameter setter functions
         MPI_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* SetSchedulerParameters() {return scheduler.get();}
+        // the constants passed to Maximize and Minimize only have to be built on process 0, every solve
+        // broadcasts them to the other processes once
+        void SetConstantsFromRoot(bool FromRoot) {ConstantsFromRoot = FromRoot;}
 
     private:
+        // returns prob on process 0 and the copy broadcast from it on the others
+        const Problem_Consts& DistributeConstants(const Problem_Consts& prob);
+
         // can encode the Subproblem_Params into a string that can be send via MPI
         MPI_Message_Encoder<Subproblem_Params> encoder;
 
+        MPI_Comm comm = MPI_COMM_NULL;
+
+        bool ConstantsFromRoot = false;
+        MPI_Message_Encoder<Problem_Consts> ConstantsEncoder;
+        MPI_Buffer ConstantsBuffer;
+        Problem_Consts ReceivedConstants;
+
         std::unique_ptr<MPI_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>> scheduler =
                 std::make_unique<MPI_Scheduler_MasterWorker<Problem_Consts, Subproblem_Params, Domain_Type>>();
     };
 
 
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    Solver_MPI<Problem_Consts, Subproblem_Params, Domain_Type>::~Solver_MPI()
+    {
+        // the scheduler frees the windows and requests it kept between solves before the communicator goes
+        scheduler.reset();
+        // a solver that outlives MPI_Finalize cannot free its communicator anymore
+        int finalized;
+        MPI_Finalized(&finalized);
+        if(!finalized) MPI_Comm_free(&comm);
+    }
+
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     Subproblem_Params Solver_MPI<Problem_Consts, Subproblem_Params, Domain_Type>::Maximize(
             const Problem_Definition<Problem_Consts, Subproblem_Params, Domain_Type>& Problem_Def,
@@ -44,7 +81,8 @@ namespace BnB{
     {
         Goal goal = Goal::MAX;
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::lowest()/2.0;
-        return scheduler->Execute(Problem_Def, prob, encoder, goal, WorstSolution);
+        scheduler->Control(this->control)->Communicator(comm);
+        return scheduler->Execute(Problem_Def, DistributeConstants(prob), encoder, goal, WorstSolution);
     }
 
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
@@ -54,7 +92,32 @@ namespace BnB{
     {
         Goal goal = Goal::MIN;
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::max()/2.0;
-        return scheduler->Execute(Problem_Def, prob, encoder, goal, WorstSolution);
+        scheduler->Control(this->control)->Communicator(comm);
+        return scheduler->Execute(Problem_Def, DistributeConstants(prob), encoder, goal, WorstSolution);
+    }
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    const Problem_Consts& Solver_MPI<Problem_Consts, Subproblem_Params, Domain_Type>::DistributeConstants(
+            const Problem_Consts& prob)
+    {
+        if(!ConstantsFromRoot) return prob;
+        int pid;
+        MPI_Comm_rank(comm, &pid);
+        // the size first, then the constants as one binary blob
+        int size = 0;
+        if(pid == 0)
+        {
+            ConstantsBuffer.Clear();
+            ConstantsEncoder.Encode_Solution(ConstantsBuffer, prob);
+            size = ConstantsBuffer.Size();
+        }
+        MPI_Bcast(&size, 1, MPI_INT, 0, comm);
+        // the root only reads its buffer
+        char* data = pid == 0 ? const_cast<char*>(ConstantsBuffer.Data()) : ConstantsBuffer.Receive(size);
+        MPI_Bcast(data, size, MPI_CHAR, 0, comm);
+        if(pid == 0) return prob;
+        ConstantsEncoder.Decode_Solution(ConstantsBuffer, ReceivedConstants);
+        return ReceivedConstants;
     }
 
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
@@ -68,8 +131,14 @@ namespace BnB{
                 scheduler = std::make_unique<MPI_Scheduler_Hybrid<Problem_Consts, Subproblem_Params, Domain_Type>>();
                 break;
             case MPI_Scheduler_Type::ONESIDED:
+                scheduler = std::make_unique<MPI_Scheduler_OneSided<Problem_Consts, Subproblem_Params, Domain_Type>>();
+                break;
+            case MPI_Scheduler_Type::WORKER_ONLY:
                 scheduler = std::make_unique<MPI_Scheduler_WorkerOnly<Problem_Consts, Subproblem_Params, Domain_Type>>();
                 break;
+            case MPI_Scheduler_Type::HIERARCHICAL:
+                scheduler = std::make_unique<MPI_Scheduler_Hierarchical<Problem_Consts, Subproblem_Params, Domain_Type>>();
+                break;
         }
     }
 }
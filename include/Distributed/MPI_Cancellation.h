@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Base.h"
+#include "Search_Control.h"
+#include <chrono>
+#include <thread>
+
+namespace BnB {
+    namespace Cancellation { // messages used to stop a search on all processes
+        enum MessageType {
+            CANCEL = 10,
+        };
+    }
+
+    // spreads a cancel of the search to all processes. The process whose control got cancelled sends an empty
+    // CANCEL message to every other process, the others see it when they Check or Wait and cancel their own
+    // control. Finish drains the CANCEL messages nobody has received yet so that the next search starts clean.
+    template<typename Subproblem_Params, typename Domain_Type>
+    class MPI_Cancellation {
+    public:
+        // called by all processes of comm before the search
+        void Start(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> c, MPI_Comm communicator) {
+            control = std::move(c);
+            comm = communicator;
+            MPI_Comm_size(comm, &num);
+            Sent = false;
+            Received = 0;
+            SendRequests.clear();
+        }
+
+        // no communication, cheap enough for every node
+        bool IsCancelled() const { return control->IsCancelled(); }
+
+        // true if the search was cancelled here or on any other process
+        bool Check() {
+            if (!control->IsCancelled()) {
+                int flag = 0;
+                MPI_Status st;
+                MPI_Iprobe(MPI_ANY_SOURCE, Cancellation::MessageType::CANCEL, comm, &flag, &st);
+                if (flag == 1)
+                    Receive(st.MPI_SOURCE);
+            }
+            if (control->IsCancelled() && !Sent && Received == 0)
+                Propagate();
+            return control->IsCancelled();
+        }
+
+        // blocks until a message other than CANCEL arrives, its envelope is stored in st.
+        // Replaces a blocking probe so that a cancel of the local control is still passed on while waiting. Once
+        // nothing is left to pass on the probe blocks, before that the process sleeps between the probes after a
+        // while, so that a waiting process does not take a core away from the others
+        void Wait(MPI_Status &st) {
+            for (int Empty = 0; ; Empty++) {
+                int flag = 1;
+                if (control->IsCancelled() && (Sent || Received > 0))
+                    MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &st);
+                else
+                    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &flag, &st);
+                if (flag == 1) {
+                    if (st.MPI_TAG != Cancellation::MessageType::CANCEL) return;
+                    Receive(st.MPI_SOURCE);
+                } else if (control->IsCancelled() && !Sent && Received == 0) {
+                    Propagate();
+                } else if (Empty > SpinProbes) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(SleepMicroseconds));
+                }
+            }
+        }
+
+        // like Wait but returns false at once if no message other than CANCEL is there
+        bool Poll(MPI_Status &st) {
+            while (true) {
+                int flag = 0;
+                MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &flag, &st);
+                if (flag == 0) {
+                    if (control->IsCancelled() && !Sent && Received == 0)
+                        Propagate();
+                    return false;
+                }
+                if (st.MPI_TAG != Cancellation::MessageType::CANCEL) return true;
+                Receive(st.MPI_SOURCE);
+            }
+        }
+
+        // called by all processes after the search, receives the CANCEL messages that are still in flight
+        void Finish() {
+            std::vector<int> SentTo(num, Sent ? 1 : 0);
+            int pid;
+            MPI_Comm_rank(comm, &pid);
+            SentTo[pid] = 0;
+            int Expected;
+            MPI_Reduce_scatter_block(SentTo.data(), &Expected, 1, MPI_INT, MPI_SUM, comm);
+            for (; Received < Expected; Received++)
+                MPI_Recv(nullptr, 0, MPI_CHAR, MPI_ANY_SOURCE, Cancellation::MessageType::CANCEL, comm,
+                         MPI_STATUS_IGNORE);
+            MPI_Waitall(SendRequests.size(), SendRequests.data(), MPI_STATUSES_IGNORE);
+        }
+
+    private:
+        void Receive(int source) {
+            MPI_Recv(nullptr, 0, MPI_CHAR, source, Cancellation::MessageType::CANCEL, comm,
+                     MPI_STATUS_IGNORE);
+            Received++;
+            control->Cancel();
+        }
+
+        // a process that learned about the cancel from a message does not pass it on, the origin sent it to all
+        void Propagate() {
+            int pid;
+            MPI_Comm_rank(comm, &pid);
+            SendRequests.assign(num, MPI_REQUEST_NULL);
+            for (int i = 0; i < num; i++)
+                if (i != pid)
+                    MPI_Isend(nullptr, 0, MPI_CHAR, i, Cancellation::MessageType::CANCEL, comm,
+                              &SendRequests[i]);
+            Sent = true;
+        }
+
+        // empty probes in Wait before it starts to sleep, short waits are not slowed down
+        static constexpr int SpinProbes = 1000;
+        static constexpr int SleepMicroseconds = 50;
+
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control;
+        MPI_Comm comm = MPI_COMM_WORLD;
+        int num = 1;
+        bool Sent = false;
+        int Received = 0;
+        std::vector<MPI_Request> SendRequests;
+    };
+}
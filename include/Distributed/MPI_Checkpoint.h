@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Base.h"
+#include "MPI_Message_Encoder.h"
+#include <cstdio>
+#include <deque>
+#include <string>
+
+namespace BnB {
+    // state of a search in one file written and read with MPI-IO, so it can be resumed by another run with any
+    // number of processes. Every process writes one block with its bound, its best subproblem, its number of solved
+    // subproblems and its open subproblems. A header in front holds the number of blocks and the offset and size of
+    // every block. The file is written under a temporary name first, so a run killed while writing keeps the last
+    // complete checkpoint
+    template<typename Subproblem_Params, typename Domain_Type>
+    class MPI_Checkpoint {
+    public:
+        // called by all processes of comm
+        void Write(const std::string &Path, MPI_Comm comm, const MPI_Message_Encoder<Subproblem_Params> &encoder,
+                   const std::deque<Subproblem_Params> &Open, Domain_Type Bound, const Subproblem_Params &Best,
+                   long long Solved) {
+            int pid, num;
+            MPI_Comm_rank(comm, &pid);
+            MPI_Comm_size(comm, &num);
+            buffer.Clear();
+            buffer.Write(Bound);
+            buffer.Write(Solved);
+            encoder.Encode_Solution(buffer, Best);
+            encoder.Encode_Package(buffer, std::vector<Subproblem_Params>(Open.begin(), Open.end()));
+
+            long long Size = buffer.Size(), Offset = 0;
+            MPI_Exscan(&Size, &Offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+            if (pid == 0) Offset = 0; // the scan leaves it undefined there
+            long long Entry[2] = {HeaderBytes(num) + Offset, Size};
+            std::vector<long long> Header(1 + 2 * num);
+            Header[0] = num;
+            MPI_Gather(Entry, 2, MPI_LONG_LONG, Header.data() + 1, 2, MPI_LONG_LONG, 0, comm);
+
+            std::string Temporary = Path + ".tmp";
+            MPI_File file;
+            MPI_File_open(comm, Temporary.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+            MPI_File_set_size(file, 0);
+            if (pid == 0)
+                MPI_File_write_at(file, 0, Header.data(), static_cast<int>(Header.size()), MPI_LONG_LONG,
+                                  MPI_STATUS_IGNORE);
+            MPI_File_write_at_all(file, Entry[0], buffer.Data(), buffer.Size(), MPI_CHAR, MPI_STATUS_IGNORE);
+            MPI_File_close(&file);
+            if (pid == 0) std::rename(Temporary.c_str(), Path.c_str());
+            MPI_Barrier(comm);
+        }
+
+        // called by all processes of comm. Every process reads a contiguous range of the blocks, then the open
+        // subproblems of all blocks are dealt round robin, so every process gets the same share no matter how many
+        // processes wrote the file. Open gets the share of this process. Bound becomes the best bound of all
+        // blocks, the process that read it also gets its subproblem in Best. Solved gets the solved subproblems
+        // of the blocks this process read
+        void Read(const std::string &Path, MPI_Comm comm, const MPI_Message_Encoder<Subproblem_Params> &encoder,
+                  const Goal goal, std::deque<Subproblem_Params> &Open, Domain_Type &Bound, Subproblem_Params &Best,
+                  long long &Solved) {
+            int pid, num;
+            MPI_Comm_rank(comm, &pid);
+            MPI_Comm_size(comm, &num);
+            MPI_File file;
+            MPI_File_open(comm, Path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+            long long Blocks;
+            MPI_File_read_at_all(file, 0, &Blocks, 1, MPI_LONG_LONG, MPI_STATUS_IGNORE);
+            std::vector<long long> Header(2 * Blocks);
+            MPI_File_read_at_all(file, sizeof(long long), Header.data(), static_cast<int>(Header.size()),
+                                 MPI_LONG_LONG, MPI_STATUS_IGNORE);
+            long long First = Blocks * pid / num, Last = Blocks * (pid + 1) / num;
+            long long Start = First < Last ? Header[2 * First] : 0;
+            int Length = First < Last ? static_cast<int>(Header[2 * Last - 2] + Header[2 * Last - 1] - Start) : 0;
+            MPI_File_read_at_all(file, Start, buffer.Receive(Length), Length, MPI_CHAR, MPI_STATUS_IGNORE);
+            MPI_File_close(&file);
+
+            std::vector<Subproblem_Params> All, Package;
+            Solved = 0;
+            for (long long i = First; i < Last; i++) {
+                Domain_Type BlockBound;
+                long long BlockSolved;
+                Subproblem_Params BlockBest;
+                buffer.Read(BlockBound);
+                buffer.Read(BlockSolved);
+                encoder.Decode_Solution(buffer, BlockBest);
+                encoder.Decode_Package(buffer, Package);
+                if (((bool) goal && BlockBound > Bound) || (!(bool) goal && BlockBound < Bound)) {
+                    Bound = BlockBound;
+                    Best = BlockBest;
+                }
+                Solved += BlockSolved;
+                std::move(Package.begin(), Package.end(), std::back_inserter(All));
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &Bound, 1, ConvertTypeToMPIType<Domain_Type>(), (bool) goal ? MPI_MAX : MPI_MIN,
+                          comm);
+
+            // the k-th subproblem of all goes to process k % num
+            long long Count = All.size(), Before = 0;
+            MPI_Exscan(&Count, &Before, 1, MPI_LONG_LONG, MPI_SUM, comm);
+            if (pid == 0) Before = 0;
+            std::vector<std::vector<Subproblem_Params>> Parts(num);
+            for (long long k = 0; k < Count; k++)
+                Parts[(Before + k) % num].push_back(std::move(All[k]));
+            std::vector<int> SendCounts(num), SendDispls(num), RecvCounts(num), RecvDispls(num);
+            buffer.Clear();
+            for (int p = 0; p < num; p++) {
+                SendDispls[p] = buffer.Size();
+                encoder.Encode_Package(buffer, Parts[p]);
+                SendCounts[p] = buffer.Size() - SendDispls[p];
+            }
+            MPI_Alltoall(SendCounts.data(), 1, MPI_INT, RecvCounts.data(), 1, MPI_INT, comm);
+            for (int p = 1; p < num; p++)
+                RecvDispls[p] = RecvDispls[p - 1] + RecvCounts[p - 1];
+            MPI_Buffer received;
+            MPI_Alltoallv(buffer.Data(), SendCounts.data(), SendDispls.data(), MPI_CHAR,
+                          received.Receive(RecvDispls[num - 1] + RecvCounts[num - 1]), RecvCounts.data(),
+                          RecvDispls.data(), MPI_CHAR, comm);
+            Open.clear();
+            for (int p = 0; p < num; p++) {
+                encoder.Decode_Package(received, Package);
+                std::move(Package.begin(), Package.end(), std::back_inserter(Open));
+            }
+        }
+
+    private:
+        static long long HeaderBytes(int Blocks) { return (1 + 2 * static_cast<long long>(Blocks)) * sizeof(long long); }
+
+        MPI_Buffer buffer;
+    };
+}
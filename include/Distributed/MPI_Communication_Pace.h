@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Base.h"
+#include <algorithm>
+#include <cmath>
+
+namespace BnB {
+    // decides after how many subproblems a process communicates and how many subproblems go into a package.
+    // Without an interval these are the fixed CommFrequency and MaximalPackageSize. With an interval the process
+    // measures its time per subproblem and the latency of its requests during the search. It then communicates
+    // about once per interval, and a package holds enough subproblems to keep the receiver busy for one latency,
+    // so that the receiver does not run dry before its next request is answered
+    class MPI_Communication_Pace {
+    public:
+        // called before the search, Interval in microseconds, 0 keeps the fixed values
+        void Start(int Frequency, int PackageSize, double Interval) {
+            Nodes = std::max(1, Frequency);
+            Highest = Nodes;
+            FixedPackageSize = PackageSize;
+            Microseconds = Interval;
+            NodeTime = 0;
+            Latency = 0;
+            Resume(0);
+        }
+
+        // subproblems between two communications
+        int Frequency() const { return Nodes; }
+
+        // biggest Frequency of the search so far
+        int HighestFrequency() const { return Highest; }
+
+        // called at every communication with the number of subproblems processed so far
+        void Communicated(long long Count) {
+            if (Microseconds <= 0) return;
+            double Now = MPI_Wtime();
+            if (Count > LastCount && Now > Last) {
+                NodeTime = Smooth(NodeTime, (Now - Last) * 1e6 / static_cast<double>(Count - LastCount));
+                Nodes = static_cast<int>(std::min(std::max(Microseconds / NodeTime, 1.0), MaxNodes));
+                Highest = std::max(Highest, Nodes);
+            }
+            LastCount = Count;
+            Last = Now;
+        }
+
+        // called when a process gets work again, the time it was idle does not count as time per subproblem
+        void Resume(long long Count) {
+            LastCount = Count;
+            Last = MPI_Wtime();
+        }
+
+        // a request is sent and its answer is received, the time in between is the latency
+        void Sent() {
+            if (Microseconds > 0) RequestTime = MPI_Wtime();
+        }
+        void Answered() {
+            if (Microseconds > 0) Latency = Smooth(Latency, (MPI_Wtime() - RequestTime) * 1e6);
+        }
+
+        // subproblems to send to another process while Open are left here. An adaptive package never gets smaller
+        // than the fixed size and never takes more than half of the open subproblems
+        int PackageSize(int Open) const {
+            if (Microseconds <= 0 || NodeTime == 0) return FixedPackageSize;
+            double Hiding = std::ceil(Latency / NodeTime);
+            return std::max(FixedPackageSize, static_cast<int>(std::min(Hiding, Open / 2.0)));
+        }
+
+    private:
+        // moving average, the first measurement is taken as it is
+        static double Smooth(double Average, double Measured) {
+            return Average == 0 ? Measured : 0.75 * Average + 0.25 * Measured;
+        }
+
+        static constexpr double MaxNodes = 1 << 24;
+
+        int Nodes = 1;
+        int Highest = 1;
+        int FixedPackageSize = 1;
+        double Microseconds = 0;
+        double NodeTime = 0; // microseconds per subproblem
+        double Latency = 0; // microseconds from a request to its answer
+        long long LastCount = 0;
+        double Last = 0;
+        double RequestTime = 0;
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <type_traits>
+#include "mpi.h"
+
+namespace BnB {
+    // true for types whose values MPI can describe with a datatype: arithmetic types and tuples, pairs and
+    // arrays of them. Anything holding pointers (vectors, strings) has no fixed layout and has to be encoded
+    template<typename T>
+    struct Is_Fixed_Layout : std::is_arithmetic<T> {};
+
+    template<typename... Ts>
+    struct Is_Fixed_Layout<std::tuple<Ts...>>
+            : std::bool_constant<(sizeof...(Ts) > 0) && (Is_Fixed_Layout<Ts>::value && ...)> {};
+
+    template<typename T, typename U>
+    struct Is_Fixed_Layout<std::pair<T, U>>
+            : std::bool_constant<Is_Fixed_Layout<T>::value && Is_Fixed_Layout<U>::value> {};
+
+    template<typename T, size_t N>
+    struct Is_Fixed_Layout<std::array<T, N>> : std::bool_constant<(N > 0) && Is_Fixed_Layout<T>::value> {};
+
+
+    template<typename T>
+    struct Is_Std_Array : std::false_type {};
+
+    template<typename T, size_t N>
+    struct Is_Std_Array<std::array<T, N>> : std::true_type {};
+
+
+    template<typename T>
+    MPI_Datatype ConvertTypeToMPIType();
+
+    // describes every member of a sample value by its offset, the extent is resized to sizeof(T)
+    // so that arrays of T are described correctly including the padding between elements
+    template<typename T>
+    MPI_Datatype CreateStructType() {
+        T sample{};
+        const char *base = reinterpret_cast<const char *>(&sample);
+        std::vector<int> lengths;
+        std::vector<MPI_Aint> displacements;
+        std::vector<MPI_Datatype> types;
+        auto add = [&](const auto &member, int length, MPI_Datatype type) {
+            lengths.push_back(length);
+            displacements.push_back(reinterpret_cast<const char *>(&member) - base);
+            types.push_back(type);
+        };
+        auto addMember = [&](const auto &member) {
+            add(member, 1, ConvertTypeToMPIType<std::decay_t<decltype(member)>>());
+        };
+
+        if constexpr (Is_Std_Array<T>::value)
+            add(sample[0], std::tuple_size<T>::value, ConvertTypeToMPIType<typename T::value_type>());
+        else // tuples and pairs
+            std::apply([&](const auto &... members) { (addMember(members), ...); }, sample);
+
+        MPI_Datatype packed, type;
+        MPI_Type_create_struct(lengths.size(), lengths.data(), displacements.data(), types.data(), &packed);
+        MPI_Type_create_resized(packed, 0, sizeof(T), &type);
+        MPI_Type_commit(&type);
+        MPI_Type_free(&packed);
+        return type;
+    }
+
+    // MPI datatype of T, built once per type at its first use (so after MPI_Init) and kept until MPI_Finalize
+    template<typename T>
+    MPI_Datatype ConvertTypeToMPIType() {
+        static_assert(Is_Fixed_Layout<T>::value, "T has no fixed memory layout that MPI could describe");
+        if constexpr (std::is_same<T, bool>::value) return MPI_C_BOOL;
+        else if constexpr (std::is_same<T, char>::value) return MPI_CHAR;
+        else if constexpr (std::is_same<T, signed char>::value) return MPI_SIGNED_CHAR;
+        else if constexpr (std::is_same<T, unsigned char>::value) return MPI_UNSIGNED_CHAR;
+        else if constexpr (std::is_same<T, short>::value) return MPI_SHORT;
+        else if constexpr (std::is_same<T, unsigned short>::value) return MPI_UNSIGNED_SHORT;
+        else if constexpr (std::is_same<T, int>::value) return MPI_INT;
+        else if constexpr (std::is_same<T, unsigned>::value) return MPI_UNSIGNED;
+        else if constexpr (std::is_same<T, long>::value) return MPI_LONG;
+        else if constexpr (std::is_same<T, unsigned long>::value) return MPI_UNSIGNED_LONG;
+        else if constexpr (std::is_same<T, long long>::value) return MPI_LONG_LONG;
+        else if constexpr (std::is_same<T, unsigned long long>::value) return MPI_UNSIGNED_LONG_LONG;
+        else if constexpr (std::is_same<T, float>::value) return MPI_FLOAT;
+        else if constexpr (std::is_same<T, double>::value) return MPI_DOUBLE;
+        else if constexpr (std::is_same<T, long double>::value) return MPI_LONG_DOUBLE;
+        else if constexpr (std::is_arithmetic<T>::value) {
+            assert(false && "arithmetic type without MPI equivalent");
+            return MPI_DATATYPE_NULL;
+        } else {
+            static MPI_Datatype type = CreateStructType<T>();
+            return type;
+        }
+    }
+
+    // a value and a rank as MPI_MAXLOC and MPI_MINLOC reduce them, MPI only has these pairs for a few value types
+    template<typename T>
+    struct Value_With_Rank {
+        T Value;
+        int Rank;
+    };
+
+    template<typename T>
+    MPI_Datatype ConvertTypeToMPIPairType() {
+        if constexpr (std::is_same<T, short>::value) return MPI_SHORT_INT;
+        else if constexpr (std::is_same<T, int>::value) return MPI_2INT;
+        else if constexpr (std::is_same<T, long>::value) return MPI_LONG_INT;
+        else if constexpr (std::is_same<T, float>::value) return MPI_FLOAT_INT;
+        else if constexpr (std::is_same<T, double>::value) return MPI_DOUBLE_INT;
+        else if constexpr (std::is_same<T, long double>::value) return MPI_LONG_DOUBLE_INT;
+        else {
+            static_assert(!std::is_same<T, T>::value, "MPI has no MAXLOC and MINLOC pair for this type");
+            return MPI_DATATYPE_NULL;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Base.h"
+#include "MPI_Datatypes.h"
+
+namespace BnB {
+    // the global incumbent bound in an MPI window on process 0, every process updates and reads it with
+    // one-sided atomics so that a new bound reaches everyone without a message to or from a master.
+    // The window is locked for the whole search (passive target), Exchange only flushes its own operation
+    template<typename Domain_Type>
+    class MPI_Incumbent_Window {
+    public:
+        ~MPI_Incumbent_Window() {
+            // a window that outlives MPI_Finalize cannot be freed anymore
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized && win != MPI_WIN_NULL) MPI_Win_free(&win);
+        }
+
+        // called by all processes of comm before the search, the window of the last search on the same
+        // communicator is reused
+        void Start(Goal g, Domain_Type WorstBound, MPI_Comm comm) {
+            goal = g;
+            Known = WorstBound;
+            int pid;
+            MPI_Comm_rank(comm, &pid);
+            if (comm != WindowComm) {
+                if (win != MPI_WIN_NULL) MPI_Win_free(&win);
+                // only max/min and reads are used, this lets MPI use hardware atomics
+                MPI_Info info;
+                MPI_Info_create(&info);
+                MPI_Info_set(info, "accumulate_ops", "same_op_no_op");
+                MPI_Win_allocate(pid == 0 ? sizeof(Domain_Type) : 0, sizeof(Domain_Type), info, comm,
+                                 &Global, &win);
+                MPI_Info_free(&info);
+                WindowComm = comm;
+            }
+            if (pid == 0) *Global = WorstBound;
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+            // the initial value has to be in the window before anybody accesses it
+            MPI_Win_sync(win);
+            MPI_Barrier(comm);
+        }
+
+        // publishes Bound if it is better than the last known global bound and reads the global bound in the
+        // same atomic operation. Returns true if Bound was overwritten by a better one from another process
+        bool Exchange(Domain_Type &Bound) {
+            MPI_Op op = IsBetter(Bound, Known) ? ((bool) goal ? MPI_MAX : MPI_MIN) : MPI_NO_OP;
+            Domain_Type Global;
+            MPI_Fetch_and_op(&Bound, &Global, ConvertTypeToMPIType<Domain_Type>(), 0, 0, op, win);
+            MPI_Win_flush(0, win);
+            bool Overwritten = IsBetter(Global, Bound);
+            if (Overwritten) Bound = Global;
+            Known = Bound;
+            return Overwritten;
+        }
+
+        // called by all processes after the search, the barrier makes sure nobody still reads the window
+        // when the next search resets it
+        void Finish() {
+            MPI_Win_unlock_all(win);
+            MPI_Barrier(WindowComm);
+        }
+
+    private:
+        bool IsBetter(Domain_Type Candidate, Domain_Type Bound) const {
+            return ((bool) goal && Candidate > Bound) || (!(bool) goal && Candidate < Bound);
+        }
+
+        Goal goal = Goal::MAX;
+        // best bound this process has seen in the window or published there
+        Domain_Type Known{};
+        MPI_Win win = MPI_WIN_NULL;
+        MPI_Comm WindowComm = MPI_COMM_NULL;
+        Domain_Type *Global = nullptr; // the bound on process 0
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Base.h"
+
+namespace BnB {
+    // the two fixed size messages a worker sends to its master as persistent requests over one stable buffer.
+    // A request for idle processes carries the bound and the number of open subproblems, an idle message is
+    // empty. Idle is synchronous like before but does not block, the worker goes on receiving while it is matched
+    template<typename Domain_Type>
+    class MPI_Master_Channel {
+    public:
+        ~MPI_Master_Channel() {
+            // requests that outlive MPI_Finalize cannot be freed anymore
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized) Release();
+        }
+
+        // called by the worker before the search, tags as in PtoP. The requests of the last search are
+        // kept if they go to the same master
+        void Start(int Master, int RequestTag, int IdleTag, MPI_Comm comm) {
+            if (RequestReq != MPI_REQUEST_NULL && Master == To && RequestTag == Tags[0] && IdleTag == Tags[1]
+                && comm == Comm)
+                return;
+            Release();
+            MPI_Send_init(Message, sizeof(Message), MPI_CHAR, Master, RequestTag, comm, &RequestReq);
+            MPI_Ssend_init(nullptr, 0, MPI_CHAR, Master, IdleTag, comm, &IdleReq);
+            To = Master;
+            Tags[0] = RequestTag;
+            Tags[1] = IdleTag;
+            Comm = comm;
+        }
+
+        // asks for idle processes, the last request has to be complete
+        void Request(Domain_Type Bound, int Open) {
+            std::memcpy(Message, &Bound, sizeof(Domain_Type));
+            std::memcpy(Message + sizeof(Domain_Type), &Open, sizeof(int));
+            MPI_Start(&RequestReq);
+        }
+
+        // the last request for idle processes, to be tested or waited for
+        MPI_Request &Pending() { return RequestReq; }
+
+        void Idle() {
+            // the master matched the last idle message before it could hand out this worker again
+            MPI_Wait(&IdleReq, MPI_STATUS_IGNORE);
+            MPI_Start(&IdleReq);
+        }
+
+        // called by the worker after the search, the master has received everything before it sent FINISH
+        void Finish() {
+            MPI_Wait(&RequestReq, MPI_STATUS_IGNORE);
+            MPI_Wait(&IdleReq, MPI_STATUS_IGNORE);
+        }
+
+    private:
+        void Release() {
+            if (RequestReq == MPI_REQUEST_NULL) return;
+            MPI_Request_free(&RequestReq);
+            MPI_Request_free(&IdleReq);
+        }
+
+        int To = -1;
+        int Tags[2] = {-1, -1};
+        MPI_Comm Comm = MPI_COMM_NULL;
+        char Message[sizeof(Domain_Type) + sizeof(int)];
+        MPI_Request RequestReq = MPI_REQUEST_NULL;
+        MPI_Request IdleReq = MPI_REQUEST_NULL;
+    };
+}
@@ -4,6 +4,11 @@
 #include <vector>
 #include <tuple>
 #include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstring>
+#include <type_traits>
+#include "MPI_Datatypes.h"
 
 // not in the namespace so the user can easily define his own function
 template<typename T>
@@ -17,6 +22,166 @@ void decodeParam(std::stringstream &ss, T &p) {
     assert(false); // if this is called it means that the encoder doesnt know how to encode the current parameter T
 }
 
+// contiguous bytes that are sent or received with MPI_CHAR. Values are appended with Write and taken out in the
+// same order with Read, the memory is kept between messages so that it only grows a few times
+class MPI_Buffer {
+public:
+    // empties the buffer for writing a new message
+    void Clear() {
+        end = 0;
+        pos = 0;
+    }
+
+    void Write(const void *src, size_t num) {
+        Grow(num);
+        std::memcpy(bytes.data() + end, src, num);
+        end += num;
+    }
+
+    // count values described by an MPI datatype, MPI gathers them straight from their memory layout
+    void Write(const void *values, int count, MPI_Datatype type) {
+        int num;
+        MPI_Pack_size(count, type, MPI_COMM_WORLD, &num);
+        Grow(num);
+        int position = 0;
+        MPI_Pack(values, count, type, bytes.data() + end, num, &position, MPI_COMM_WORLD);
+        end += position;
+    }
+
+    template<typename T>
+    void Write(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be copied bytewise");
+        Write(&value, sizeof(T));
+    }
+
+    void Read(void *dst, size_t num) {
+        assert(pos + num <= end && "read past the end of the message");
+        std::memcpy(dst, bytes.data() + pos, num);
+        pos += num;
+    }
+
+    template<typename T>
+    void Read(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be copied bytewise");
+        Read(&value, sizeof(T));
+    }
+
+    // counterpart of the typed Write, scatters the values right into their destination
+    void Read(void *values, int count, MPI_Datatype type) {
+        int position = 0;
+        MPI_Unpack(bytes.data() + pos, end - pos, &position, values, count, type, MPI_COMM_WORLD);
+        pos += position;
+    }
+
+    // returns room for a message of up to num bytes, the message is then read from its beginning
+    char *Receive(size_t num) {
+        if (num > bytes.size())
+            bytes.resize(num);
+        end = num;
+        pos = 0;
+        return bytes.data();
+    }
+
+    const char *Data() const { return bytes.data(); }
+
+    int Size() const { return static_cast<int>(end); }
+
+private:
+    void Grow(size_t num) {
+        if (end + num > bytes.size())
+            bytes.resize(std::max(2 * bytes.size(), end + num));
+    }
+
+    std::vector<char> bytes;
+    size_t end = 0; // end of the message
+    size_t pos = 0; // next byte to read
+};
+
+
+// binary encoding of a single parameter, selected at compile time from its type.
+// Trivially copyable values are copied as they are, vectors are written as their length followed by the elements
+// (one memcpy for trivially copyable elements), pairs and tuples element by element.
+// Everything else falls back to the text encoding of encodeParam, so a type that has its own encodeParam
+// can be sent without writing a binary version
+template<typename T>
+void encodeBinary(MPI_Buffer &buf, const T &p);
+
+template<typename T>
+void decodeBinary(MPI_Buffer &buf, T &p);
+
+template<typename T>
+void encodeBinary(MPI_Buffer &buf, const std::vector<T> &p) {
+    buf.Write(p.size());
+    if constexpr (std::is_trivially_copyable<T>::value)
+        buf.Write(p.data(), p.size() * sizeof(T));
+    else
+        for (const auto &el : p)
+            encodeBinary(buf, el);
+}
+
+template<typename T>
+void decodeBinary(MPI_Buffer &buf, std::vector<T> &p) {
+    size_t len;
+    buf.Read(len);
+    p.resize(len);
+    if constexpr (std::is_trivially_copyable<T>::value)
+        buf.Read(p.data(), len * sizeof(T));
+    else
+        for (auto &el : p)
+            decodeBinary(buf, el);
+}
+
+template<typename T, typename U>
+void encodeBinary(MPI_Buffer &buf, const std::pair<T, U> &p) {
+    encodeBinary(buf, p.first);
+    encodeBinary(buf, p.second);
+}
+
+template<typename T, typename U>
+void decodeBinary(MPI_Buffer &buf, std::pair<T, U> &p) {
+    decodeBinary(buf, p.first);
+    decodeBinary(buf, p.second);
+}
+
+template<typename... Ts>
+void encodeBinary(MPI_Buffer &buf, const std::tuple<Ts...> &p) {
+    std::apply([&buf](auto &&... args) { (encodeBinary(buf, args), ...); }, p);
+}
+
+template<typename... Ts>
+void decodeBinary(MPI_Buffer &buf, std::tuple<Ts...> &p) {
+    std::apply([&buf](auto &&... args) { (decodeBinary(buf, args), ...); }, p);
+}
+
+template<typename T>
+void encodeBinary(MPI_Buffer &buf, const T &p) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        buf.Write(p);
+    } else {
+        std::stringstream ss;
+        ss << std::setprecision(15);
+        encodeParam(ss, p);
+        std::string text = ss.str();
+        buf.Write(text.size());
+        buf.Write(text.data(), text.size());
+    }
+}
+
+template<typename T>
+void decodeBinary(MPI_Buffer &buf, T &p) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        buf.Read(p);
+    } else {
+        size_t len;
+        buf.Read(len);
+        std::string text(len, ' ');
+        buf.Read(&text[0], len);
+        std::stringstream ss(text);
+        decodeParam(ss, p);
+    }
+}
+
+
 template<class Solution_Parameters>
 class MPI_Message_Encoder {
 public: // make it a friend of Solver maybe
@@ -35,12 +200,44 @@ public: // make it a friend of Solver maybe
         std::apply([&ss](auto &&... args) { (decodeParam(ss, args), ...); },
                    params); // applies encode parameter on all elements
     }
+
+    // binary versions used by the schedulers, see encodeBinary
+    void Encode_Solution(MPI_Buffer &buf, const Solution_Parameters &params) const {
+        encodeBinary(buf, params);
+    }
+
+    void Decode_Solution(MPI_Buffer &buf, Solution_Parameters &params) const {
+        decodeBinary(buf, params);
+    }
+
+    // a work package, its size followed by the subproblems. Subproblems with a fixed layout
+    // (see BnB::Is_Fixed_Layout) are written as one typed array with no per element encoding
+    void Encode_Package(MPI_Buffer &buf, const std::vector<Solution_Parameters> &package) const {
+        buf.Write(static_cast<int>(package.size()));
+        if constexpr (BnB::Is_Fixed_Layout<Solution_Parameters>::value)
+            buf.Write(package.data(), package.size(), BnB::ConvertTypeToMPIType<Solution_Parameters>());
+        else
+            for (const auto &params : package)
+                encodeBinary(buf, params);
+    }
+
+    // replaces the content of package
+    void Decode_Package(MPI_Buffer &buf, std::vector<Solution_Parameters> &package) const {
+        int size;
+        buf.Read(size);
+        package.resize(size);
+        if constexpr (BnB::Is_Fixed_Layout<Solution_Parameters>::value)
+            buf.Read(package.data(), size, BnB::ConvertTypeToMPIType<Solution_Parameters>());
+        else
+            for (auto &params : package)
+                decodeBinary(buf, params);
+    }
 };
 
 // --------------------------------------------------------------------------
 // specializations for different basic types including vectors of these types
 // TODO C++20 concepts
-// TODO develop some automatic way to create MPI_Types
+// packages of subproblems with a fixed layout skip these and go as MPI datatypes, see MPI_Datatypes.h
 // --------------------------------------------------------------------------
 template<>
 void encodeParam(std::stringstream &ss, const int &p) {
@@ -2,6 +2,10 @@
 
 #include "Base.h"
 #include "MPI_Message_Encoder.h"
+#include "MPI_Cancellation.h"
+#include "MPI_Incumbent_Window.h"
+#include "MPI_Master_Channel.h"
+#include "MPI_Communication_Pace.h"
 
 namespace BnB {
     namespace PtoP { // messages used in Point to Point based schedulers (MasterWorker and Hybrid
@@ -10,10 +14,41 @@ namespace BnB {
         };
     }
 
+    namespace Result { // the best solution sent to process 0 after the search, see ExtractBestSolution
+        enum MessageType {
+            SOLUTION = 30,
+        };
+    }
+
+    // how the master hands out the first work: NONE sends the root to one worker and the others wait until it asks
+    // for help. MASTER_BFS expands the root on the master until every worker can get some subproblems.
+    // With RACING every worker expands the same first subproblems itself and keeps its share, nothing is sent
+    enum class RampUp_Type {
+        NONE, MASTER_BFS, RACING,
+    };
+
+    // what this process did in the last search, for tests and benchmarks. A counter stays 0 where the scheduler
+    // has nothing of the kind
+    struct MPI_Search_Stats {
+        long long Solved = 0;          // subproblems taken from the own queue
+        long long PackagesSent = 0;    // work packages sent to another process, empty ones do not count
+        long long RampUpShare = 0;     // subproblems a worker started with from the ramp-up
+        long long Steals = 0;          // successful steals from another process
+        long long FailedSteals = 0;    // steals that found nothing
+        long long PoolTakes = 0;       // subproblems taken from the node pool of WORKER_ONLY
+        long long KeptTooBig = 0;      // times a subproblem did not fit the ring or the node pool and stayed here
+        long long PackagesPooled = 0;  // packages the master took into the global pool
+        long long LargestPool = 0;     // most subproblems the global pool held at once
+        long long WindowExchanges = 0; // accesses to the incumbent window
+        int HighestFrequency = 0;      // most subproblems between two communications the pace chose
+    };
+
     // strategy pattern that holds the actual MPI algorithm to schedule the work
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
     class MPI_Scheduler {
     public:
+        virtual ~MPI_Scheduler() = default;
+
         virtual Subproblem_Params
         Execute(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                 const Prob_Consts &prob,
@@ -26,149 +61,315 @@ namespace BnB {
         MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *Eps(Domain_Type e) {eps = e; return this;}
         MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *TraversMode(TraversalMode m) {mode = m; return this;};
         MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *MaximalPackageSize(int size) {MaxPackageSize = size; return this;}
+        // the workers communicate about every Microseconds instead of every CommFrequency subproblems, the frequency
+        // and the package size follow the measured time per subproblem and message latency. The package size then
+        // is the smallest package, 0 turns it off
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *CommInterval(double Microseconds) {CommunicationInterval = Microseconds; return this;}
+        // the search runs on the processes of this communicator, the solver sets it to its own duplicate
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *Communicator(MPI_Comm c) {comm = c; return this;}
+        // the search reports its progress to this control and stops on all processes once it is cancelled on one
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *Control(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> c) {control = std::move(c); return this;}
+        // keeps the global incumbent bound in an MPI window that the workers update and read with one-sided atomics
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *SharedIncumbent(bool use) {UseIncumbentWindow = use; return this;}
+        // the master of PRIORITY and HYBRID expands subproblems itself between the messages it serves
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *WorkingMaster(bool use) {MasterWorks = use; return this;}
+        // the master of PRIORITY and HYBRID keeps up to size of the best open subproblems and gives them to idle
+        // processes, 0 turns the pool off
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *GlobalPool(int size) {PoolSize = size; return this;}
+        // ramp-up of PRIORITY and HYBRID, it creates NodesPerProcess subproblems for every worker
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *RampUp(RampUp_Type type, int NodesPerProcess = 4) {Ramp = type; RampUpNodes = NodesPerProcess; return this;}
+        // every process returns the best solution, not only process 0
+        MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> *SolutionOnAllRanks(bool all) {BroadcastSolution = all; return this;}
+
+        // counters of this process for the last search
+        const MPI_Search_Stats &Stats() const { return stats; }
 
     protected:
+        // makes sure there is one send buffer and request per process, the buffers are members so that
+        // repeated solves with the same scheduler reuse them instead of building new ones every time
+        void PrepareBuffers(int num);
+
+        // resets the control and the cancellation, has to be called by all processes before the search
+        void StartSearch(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                         const Prob_Consts &prob, const Goal goal, const Domain_Type WorstBound) {
+            control->Start(goal, WorstBound,
+                           std::get<0>(Problem_Def.GetEstimateForBounds(prob, Problem_Def.GetInitialSubproblem(prob))));
+            stats = MPI_Search_Stats();
+            cancellation.Start(control, comm);
+            pace.Start(Communication_Frequency, MaxPackageSize, CommunicationInterval);
+            if (UseIncumbentWindow) incumbentWindow.Start(goal, WorstBound, comm);
+        }
+
+        // counterpart of StartSearch, has to be called by all processes after the search
+        void FinishSearch() {
+            if (UseIncumbentWindow) incumbentWindow.Finish();
+            cancellation.Finish();
+            control->Finish();
+            stats.HighestFrequency = pace.HighestFrequency();
+        }
+
+        // completes the sends in req that are done without waiting for the others, so that the next package to
+        // the same process rarely has to wait
+        void TestSends() {
+            int done;
+            MPI_Testsome(req.size(), req.data(), &done, Completed.data(), MPI_STATUSES_IGNORE);
+            if (done == MPI_UNDEFINED) return;
+            for (int i = 0; i < done; i++)
+                OpenRequests[Completed[i]] = false;
+        }
+
+        // number of the Open local subproblems a worker sends to Destination. The pool of the master only has room
+        // for MaxPackageSize subproblems per package it asked for, so an adaptive package to it is cut to that
+        int PackageSizeFor(int Destination, int Open) const {
+            int size = pace.PackageSize(Open);
+            return Destination == 0 && PoolSize > 0 ? std::min(size, MaxPackageSize) : size;
+        }
+
+        // publishes a better local bound and takes a better global one, does nothing without SharedIncumbent
+        void ShareBound(Domain_Type &LocalBestBound) {
+            if (!UseIncumbentWindow) return;
+            stats.WindowExchanges++;
+            if (incumbentWindow.Exchange(LocalBestBound))
+                control->BoundImproved(LocalBestBound);
+        }
+
+        MPI_Comm comm = MPI_COMM_WORLD;
         int Communication_Frequency = 1;
         Domain_Type eps;
         TraversalMode mode = TraversalMode::DFS;
         int MaxPackageSize = 1;
-
+        double CommunicationInterval = 0;
+        bool MasterWorks = false;
+        int PoolSize = 0;
+        RampUp_Type Ramp = RampUp_Type::NONE;
+        int RampUpNodes = 4;
+        bool BroadcastSolution = false;
+
+        std::vector<MPI_Buffer> sendbuffers;
+        MPI_Buffer receivbuffer;
+        std::vector<MPI_Request> req;
+        std::vector<bool> OpenRequests;
+        std::vector<int> Completed;
+        MPI_Master_Channel<Domain_Type> channel;
+        MPI_Communication_Pace pace;
+        MPI_Search_Stats stats;
+
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control =
+                std::make_shared<Search_Control<Subproblem_Params, Domain_Type>>();
+        MPI_Cancellation<Subproblem_Params, Domain_Type> cancellation;
+        bool UseIncumbentWindow = false;
+        MPI_Incumbent_Window<Domain_Type> incumbentWindow;
     };
 
-    // get next id if you are the last proc then send to 0
-    void Next(int &id, int num) {
-        id = (id + 1) % num;
-        if (id == 0) id = 1;
-    }
-
-
-    // Master used by MasterWorker and Hybrid that does a initial split of the domain, besides that it does the same as the normal master
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
-    Subproblem_Params SplittingMasterBehavior(std::vector<std::stringstream> &sendstream,
-                                              std::stringstream &receivstream,
-                                              const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
-                                              const Prob_Consts &prob,
-                                              const MPI_Message_Encoder <Subproblem_Params> &encoder,
-                                              const Goal goal,
-                                              const Domain_Type WorstBound) {
-        char buffer[20000];
-        int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
-        MPI_Status st;
-        std::vector<MPI_Request> req(num);
-        std::vector<bool> OpenRequests(num, false);
+    void MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type>::PrepareBuffers(int num) {
+        sendbuffers.resize(num);
+        for (auto &buffer : sendbuffers)
+            buffer.Clear();
+        receivbuffer.Clear();
+        req.assign(num, MPI_REQUEST_NULL);
+        OpenRequests.assign(num, false);
+        Completed.resize(num);
+    }
 
-        int NumMessages = 0;
+    // receives the next message from source with tag whatever its size, the buffer grows to fit it.
+    // The matched probe makes sure no other thread can take the message between probe and receive
+    inline void ReceiveMessage(MPI_Buffer &buffer, int source, int tag, MPI_Status &st, MPI_Comm comm) {
+        MPI_Message message;
+        MPI_Mprobe(source, tag, comm, &message, &st);
+        int count;
+        MPI_Get_count(&st, MPI_CHAR, &count);
+        MPI_Mrecv(buffer.Receive(count), count, MPI_CHAR, &message, &st);
+    }
 
-        Domain_Type GlobalBestBound = WorstBound;
-        Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+    // sorts the other processes into the ones on the same node as this one (they share memory with it) and
+    // the ones on other nodes. Has to be called by all processes
+    inline void SplitByNode(std::vector<int> &SameNode, std::vector<int> &OtherNodes, MPI_Comm comm) {
+        int pid, num, size;
+        MPI_Comm_rank(comm, &pid);
+        MPI_Comm_size(comm, &num);
+        MPI_Comm node;
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, pid, MPI_INFO_NULL, &node);
+        MPI_Comm_size(node, &size);
+        std::vector<int> members(size);
+        MPI_Allgather(&pid, 1, MPI_INT, members.data(), 1, MPI_INT, node);
+        MPI_Comm_free(&node);
+
+        std::vector<bool> local(num, false);
+        for (int member : members) local[member] = true;
+        SameNode.clear();
+        OtherNodes.clear();
+        for (int i = 0; i < num; i++)
+            if (i != pid) (local[i] ? SameNode : OtherNodes).push_back(i);
+    }
 
 
-        std::vector<Subproblem_Params> subproblems = Problem_Def.SplitSolution(prob, BestSubproblem);
-        printProc("there are " << subproblems.size() << " problems that i need to sent")
-        int ProblemsToDivide = subproblems.size();
-        std::vector<bool> sentToID(num + 2, false);
-        // if there are more workers than tasks
-        if (num - 1 > subproblems.size()) {
-            int size = subproblems.size();
-            for (int i = 1; i <= size; i++) {
-                Subproblem_Params currentSub = subproblems.back();
-                subproblems.pop_back();
-                int Numpacks = 1;
-                sendstream[i] << Numpacks << " ";
-                MPI_Send(sendstream[i].str().c_str(), strlen(sendstream[i].str().c_str()), MPI_CHAR, i,
-                         PtoP::MessageType::INITIAL, MPI_COMM_WORLD);
-                sendstream[i].str("");
-                sendstream[i] << 1 << " ";
-                encoder.Encode_Solution(sendstream[i], currentSub);
-                MPI_Send(sendstream[i].str().c_str(), strlen(sendstream[i].str().c_str()), MPI_CHAR, i,
-                         PtoP::MessageType::INITIAL, MPI_COMM_WORLD);
-                sendstream[i].str("");
-                sentToID[i] = true;
-            }
-        } else { // if the number of tasks is bigger than the number of workers
-            const int MaxPackSize = 5;
-            int i = 0;
-            std::vector<int> PackSizes;
-            while (true) {
-                if ((PackSizes.size() + 1) * MaxPackSize <= ProblemsToDivide)
-                    PackSizes.push_back(MaxPackSize);
-                else {
-                    PackSizes.push_back(subproblems.size() - PackSizes.size() * MaxPackSize);
-                    break;
+    // expands the root breadth first until there are at least Count open subproblems or none are left. Only the
+    // bounds found on the way are used, so all processes that call it get the same subproblems
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    std::deque<Subproblem_Params> ExpandBreadthFirst(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                                     const Prob_Consts &prob,
+                                                     const Goal goal,
+                                                     const Domain_Type eps,
+                                                     const int Count,
+                                                     Search_Control<Subproblem_Params, Domain_Type> &control,
+                                                     Domain_Type &BestBound,
+                                                     Subproblem_Params &BestSubproblem) {
+        std::deque<Subproblem_Params> Queue{Problem_Def.GetInitialSubproblem(prob)};
+        while (!Queue.empty() && (int) Queue.size() < Count) {
+            Subproblem_Params sol = Queue.front();
+            Queue.pop_front();
+
+            auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+            if (((bool) goal && LowerBound < BestBound) || (!(bool) goal && LowerBound > BestBound))
+                continue;
+
+            auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+            Domain_Type CandidateBound = UpperBound;
+            if (Feasibility == BnB::FEASIBILITY::NONE)
+                continue;
+            if (Feasibility == BnB::FEASIBILITY::Full) {
+                CandidateBound = Problem_Def.GetContainedUpperBound(prob, sol);
+                if (((bool) goal && CandidateBound >= BestBound) || (!(bool) goal && CandidateBound <= BestBound)) {
+                    BestBound = CandidateBound;
+                    BestSubproblem = sol;
+                    control.Improved(CandidateBound, sol);
                 }
             }
-            int PacksNeedToSend = std::ceil(PackSizes.size() / ((float) (num - 1.0)));
-            printProc("Packs of work sent to each proc " << PacksNeedToSend)
-
-
-            std::for_each(PackSizes.begin(), PackSizes.end(), [](int i) { std::cout << i << " "; });
-            std::cout << std::endl;
-
-            while (!subproblems.empty()) {
-                Next(i, num);
-                sentToID[i] = true;
-
-                if (i == num - 1) PacksNeedToSend = PackSizes.size();
-                sendstream[i].str("");
-                sendstream[i] << PacksNeedToSend << " ";
-                MPI_Send(sendstream[i].str().c_str(), strlen(sendstream[i].str().c_str()), MPI_CHAR, i,
-                         PtoP::MessageType::INITIAL, MPI_COMM_WORLD);
-                sendstream[i].str("");
-
-                for (int j = 0; j < PacksNeedToSend; j++) {
-                    int PackSize = PackSizes.front();
-                    PackSizes.erase(PackSizes.begin());
-                    sendstream[i] << PackSize << " ";
-                    for (int p = 0; p < PackSize; p++) {
-                        Subproblem_Params currentSub = subproblems.back();
-                        subproblems.pop_back();
-                        encoder.Encode_Solution(sendstream[i], currentSub);
-                    }
-                    MPI_Send(sendstream[i].str().c_str(), strlen(sendstream[i].str().c_str()), MPI_CHAR, i,
-                             PtoP::MessageType::INITIAL, MPI_COMM_WORLD);
-                    sendstream[i].str("");
-                }
 
+            if (std::abs(CandidateBound - LowerBound) > eps) {
+                for (auto &&el : Problem_Def.SplitSolution(prob, sol))
+                    Queue.push_back(el);
             }
         }
+        return Queue;
+    }
+
+    // every Workers-th subproblem starting at Worker, neighbouring subproblems of a breadth first expansion
+    // end up with different workers
+    template<typename Subproblem_Params>
+    std::deque<Subproblem_Params> ShareOf(const std::deque<Subproblem_Params> &All, int Worker, int Workers) {
+        std::deque<Subproblem_Params> Share;
+        for (size_t i = Worker; i < All.size(); i += Workers)
+            Share.push_back(All[i]);
+        return Share;
+    }
 
-        // stores idleProcIds;
+    // the start of the masters used by MasterWorker and Hybrid, hands out the first work as selected by ramp
+    // and returns the workers that got none
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    std::vector<int> DistributeInitialWork(std::vector<MPI_Buffer> &sendbuffer,
+                                           const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                           const Prob_Consts &prob,
+                                           const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                                           const Goal goal,
+                                           const Domain_Type eps,
+                                           const RampUp_Type ramp,
+                                           const int NodesPerProcess,
+                                           Search_Control<Subproblem_Params, Domain_Type> &control,
+                                           Domain_Type &GlobalBestBound,
+                                           Subproblem_Params &BestSubproblem,
+                                           MPI_Comm comm) {
+        int num;
+        MPI_Comm_size(comm, &num);
         std::vector<int> idleProcIds;
+        if (ramp == RampUp_Type::NONE) {
+            for (int i = 2; i < num; i++) {
+                idleProcIds.push_back(i);
+            }
+            // encode initial problem and empty sol into the buffer
+            sendbuffer[1].Clear();
+            encoder.Encode_Package(sendbuffer[1], {BestSubproblem});
+            sendbuffer[1].Write(GlobalBestBound);
+            // send it to idle processor no. 1
+            MPI_Send(sendbuffer[1].Data(), sendbuffer[1].Size(), MPI_CHAR, 1,
+                     PtoP::MessageType::PROB, comm);
+            return idleProcIds;
+        }
+
+        // the master expands the same subproblems as the racing workers to start with their bound
+        std::deque<Subproblem_Params> All = ExpandBreadthFirst(Problem_Def, prob, goal, eps,
+                                                               NodesPerProcess * (num - 1), control,
+                                                               GlobalBestBound, BestSubproblem);
+        if (ramp == RampUp_Type::RACING)
+            return idleProcIds;
+
         for (int i = 1; i < num; i++) {
-            if (sentToID[i] == false)
+            std::deque<Subproblem_Params> Share = ShareOf(All, i - 1, num - 1);
+            if (Share.empty()) {
                 idleProcIds.push_back(i);
+                continue;
+            }
+            sendbuffer[i].Clear();
+            encoder.Encode_Package(sendbuffer[i], std::vector<Subproblem_Params>(Share.begin(), Share.end()));
+            sendbuffer[i].Write(GlobalBestBound);
+            MPI_Send(sendbuffer[i].Data(), sendbuffer[i].Size(), MPI_CHAR, i,
+                     PtoP::MessageType::PROB, comm);
         }
-        std::for_each(idleProcIds.begin(), idleProcIds.end(), [](bool i) { std::cout << i << " "; });
-        // TODO this is the same as for default master, refactor into one core function
+        return idleProcIds;
+    }
+
+
+    // the Master code that is used by MasterWorker and Hybrif
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params DefaultMasterBehavior(std::vector<MPI_Buffer> &sendbuffer,
+                                            MPI_Buffer &receivbuffer,
+                                            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                            const Prob_Consts &prob,
+                                            const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                                            const Goal goal,
+                                            const Domain_Type WorstBound,
+                                            Search_Control<Subproblem_Params, Domain_Type> &control,
+                                            MPI_Cancellation<Subproblem_Params, Domain_Type> &cancellation,
+                                            MPI_Search_Stats &stats,
+                                            const Domain_Type eps,
+                                            const RampUp_Type ramp,
+                                            const int RampUpNodes,
+                                            MPI_Comm comm) {
+        int pid, num;
+        MPI_Comm_rank(comm, &pid);
+        MPI_Comm_size(comm, &num);
+        MPI_Status st;
+        std::vector<MPI_Request> req(num);
+        std::vector<bool> OpenRequests(num, false);
+
+        int NumMessages = 0;
+
+        Domain_Type GlobalBestBound = WorstBound;
+        //master processor
+        Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+
+        std::vector<int> idleProcIds = DistributeInitialWork(sendbuffer, Problem_Def, prob, encoder, goal, eps, ramp,
+                                                             RampUpNodes, control, GlobalBestBound, BestSubproblem,
+                                                             comm);
         while (idleProcIds.size() != num - 1) {
-            MPI_Recv(buffer, 2000, MPI_CHAR, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+            cancellation.Wait(st);
+            ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, comm);
             NumMessages++;
-            receivstream.str(buffer);
             if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) {
                 int sl_needed;
                 int r = st.MPI_SOURCE;
 
                 Domain_Type CandidateBound;
-                receivstream >> CandidateBound;
+                receivbuffer.Read(CandidateBound);
 
                 if (((bool) goal && CandidateBound > GlobalBestBound) ||
                     (!(bool) goal && CandidateBound < GlobalBestBound)) {
                     GlobalBestBound = CandidateBound;
+                    control.BoundImproved(GlobalBestBound);
                 }
 
-                receivstream >> sl_needed;
-                int sl_given = std::min(sl_needed, (int) idleProcIds.size());;
-                sendstream[r].str("");
-                sendstream[r] << GlobalBestBound << " ";
-                sendstream[r] << sl_given << " ";
-
-                std::for_each(idleProcIds.begin(), idleProcIds.begin() + sl_given,
-                              [&sendstream, &r](const int &el) { sendstream[r] << el << " "; });
+                receivbuffer.Read(sl_needed);
+                // after a cancel no more work is spread, the workers empty their queues and become idle
+                int sl_given = cancellation.IsCancelled() ? 0 : std::min(sl_needed, (int) idleProcIds.size());
+                // the last answer to r may still be in flight, its buffer can only be reused once it is sent
                 if (OpenRequests[r]) MPI_Wait(&req[r], MPI_STATUS_IGNORE);
-                MPI_Isend(&sendstream[r].str()[0], strlen(sendstream[r].str().c_str()), MPI_CHAR, r,
-                          PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD, &req[r]);
+                sendbuffer[r].Clear();
+                sendbuffer[r].Write(GlobalBestBound);
+                sendbuffer[r].Write(sl_given);
+                sendbuffer[r].Write(idleProcIds.data(), sl_given * sizeof(int));
+                MPI_Isend(sendbuffer[r].Data(), sendbuffer[r].Size(), MPI_CHAR, r,
+                          PtoP::MessageType::GET_WORKERS, comm, &req[r]);
                 OpenRequests[r] = true;
                 idleProcIds.erase(idleProcIds.begin(), idleProcIds.begin() + sl_given);
             } else if (st.MPI_TAG == PtoP::MessageType::IDLE) {
@@ -178,133 +379,392 @@ namespace BnB {
         }
 
         for (int i = 1; i < num; i++) {
-            MPI_Send(buffer, 1, MPI_CHAR, i, PtoP::MessageType::FINISH, MPI_COMM_WORLD);
+            MPI_Send(nullptr, 0, MPI_CHAR, i, PtoP::MessageType::FINISH, comm);
         }
 
+        // the workers received every message before FINISH, waiting keeps the buffers safe for the next search
         for (int i = 1; i < num; i++)
-            if (OpenRequests[i]) MPI_Request_free(&req[i]);
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
         printProc("the master received a total of " << NumMessages << " messages");
         return BestSubproblem;
     }
 
 
-    // the Master code that is used by MasterWorker and Hybrif
+    // master that also expands subproblems, used by MasterWorker and Hybrid with WorkingMaster. It only expands
+    // a subproblem when no message is waiting, so a worker waits for at most one expansion. Towards the workers
+    // the master is process 0 in the list of idle processes: a worker that gets it sends it a package like to
+    // any other idle process, and the master gives work from its own queue to idle processes without a request
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
-    Subproblem_Params DefaultMasterBehavior(std::vector<std::stringstream> &sendstream,
-                                            std::stringstream &receivstream,
+    Subproblem_Params WorkingMasterBehavior(std::vector<MPI_Buffer> &sendbuffer,
+                                            MPI_Buffer &receivbuffer,
                                             const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                                             const Prob_Consts &prob,
                                             const MPI_Message_Encoder <Subproblem_Params> &encoder,
                                             const Goal goal,
-                                            const Domain_Type WorstBound) {
-        char buffer[2000];
+                                            const Domain_Type WorstBound,
+                                            Search_Control<Subproblem_Params, Domain_Type> &control,
+                                            MPI_Cancellation<Subproblem_Params, Domain_Type> &cancellation,
+                                            MPI_Search_Stats &stats,
+                                            const TraversalMode mode,
+                                            const Domain_Type eps,
+                                            const int MaxPackageSize,
+                                            const int CommFrequency,
+                                            const RampUp_Type ramp,
+                                            const int RampUpNodes,
+                                            MPI_Comm comm) {
         int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
+        MPI_Comm_rank(comm, &pid);
+        MPI_Comm_size(comm, &num);
         MPI_Status st;
         std::vector<MPI_Request> req(num);
         std::vector<bool> OpenRequests(num, false);
 
         int NumMessages = 0;
+        int NumProblemsSolved = 0;
+        int counter = 0;
 
         Domain_Type GlobalBestBound = WorstBound;
-        //master processor
         Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+        std::deque<Subproblem_Params> LocalTaskQueue;
+        std::vector<Subproblem_Params> ReceivedPackage;
+
+        auto UpdateBound = [&](Domain_Type CandidateBound) {
+            if (((bool) goal && CandidateBound > GlobalBestBound) ||
+                (!(bool) goal && CandidateBound < GlobalBestBound)) {
+                GlobalBestBound = CandidateBound;
+                control.BoundImproved(GlobalBestBound);
+            }
+        };
 
-        // stores idleProcIds;
-        std::vector<int> idleProcIds;
-        for (int i = 2; i < num; i++) {
-            idleProcIds.push_back(i);
+        std::vector<int> idleProcIds = DistributeInitialWork(sendbuffer, Problem_Def, prob, encoder, goal, eps, ramp,
+                                                             RampUpNodes, control, GlobalBestBound, BestSubproblem,
+                                                             comm);
+        // the master comes last so that the workers are given out first
+        idleProcIds.push_back(0);
+        while ((int) idleProcIds.size() != num) {
+            bool MessageWaits;
+            if (LocalTaskQueue.empty()) {
+                cancellation.Wait(st);
+                MessageWaits = true;
+            } else {
+                MessageWaits = cancellation.Poll(st);
+            }
+
+            if (MessageWaits) {
+                ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, comm);
+                NumMessages++;
+                if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) {
+                    int sl_needed;
+                    int r = st.MPI_SOURCE;
+
+                    Domain_Type CandidateBound;
+                    receivbuffer.Read(CandidateBound);
+                    UpdateBound(CandidateBound);
+
+                    receivbuffer.Read(sl_needed);
+                    // after a cancel no more work is spread, the workers empty their queues and become idle
+                    int sl_given = cancellation.IsCancelled() ? 0 : std::min(sl_needed, (int) idleProcIds.size());
+                    // the last answer to r may still be in flight, its buffer can only be reused once it is sent
+                    if (OpenRequests[r]) MPI_Wait(&req[r], MPI_STATUS_IGNORE);
+                    sendbuffer[r].Clear();
+                    sendbuffer[r].Write(GlobalBestBound);
+                    sendbuffer[r].Write(sl_given);
+                    sendbuffer[r].Write(idleProcIds.data(), sl_given * sizeof(int));
+                    MPI_Isend(sendbuffer[r].Data(), sendbuffer[r].Size(), MPI_CHAR, r,
+                              PtoP::MessageType::GET_WORKERS, comm, &req[r]);
+                    OpenRequests[r] = true;
+                    idleProcIds.erase(idleProcIds.begin(), idleProcIds.begin() + sl_given);
+                } else if (st.MPI_TAG == PtoP::MessageType::IDLE) {
+                    //slave has become idle
+                    idleProcIds.push_back(st.MPI_SOURCE);
+                } else if (st.MPI_TAG == PtoP::MessageType::PROB) {
+                    // a worker was told the master is idle
+                    encoder.Decode_Package(receivbuffer, ReceivedPackage);
+                    std::move(ReceivedPackage.begin(), ReceivedPackage.end(), std::back_inserter(LocalTaskQueue));
+                    Domain_Type newBoundValue;
+                    receivbuffer.Read(newBoundValue);
+                    UpdateBound(newBoundValue);
+                    if (LocalTaskQueue.empty()) idleProcIds.push_back(0);
+                }
+                continue;
+            }
+
+            // no message waits, expand one subproblem
+            if (counter % CommFrequency == 0 && cancellation.Check())
+                LocalTaskQueue.clear();
+            while (!LocalTaskQueue.empty()) {
+                NumProblemsSolved++;
+                stats.Solved++;
+                Subproblem_Params sol = GetNextSubproblem(LocalTaskQueue, mode);
+
+                //ignore if its bound is worse than already known best sol.
+                auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+                if (((bool) goal && LowerBound < GlobalBestBound)
+                    || (!(bool) goal && LowerBound > GlobalBestBound)) {
+                    continue;
+                }
+
+                // try to make the bound better only if the solution lies in a feasible domain
+                auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+                Domain_Type CandidateBound;
+                if (Feasibility == BnB::FEASIBILITY::Full) {
+                    CandidateBound = (Problem_Def.GetContainedUpperBound(prob, sol));
+                    if (((bool) goal && CandidateBound >= GlobalBestBound)
+                        || (!(bool) goal && CandidateBound <= GlobalBestBound)) {
+                        GlobalBestBound = CandidateBound;
+                        BestSubproblem = sol;
+                        control.Improved(CandidateBound, sol);
+                    }
+                } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
+                    // use our backup for the CandidateBound
+                    CandidateBound = UpperBound;
+                } else if (Feasibility == BnB::FEASIBILITY::NONE) // basically discard again
+                    continue;
+
+                if (std::abs(CandidateBound - LowerBound) > eps) { // epsilon criterion for convergence
+                    for (auto &&el : Problem_Def.SplitSolution(prob, sol))
+                        LocalTaskQueue.push_back(el);
+                }
+                // one expanded subproblem, pruned ones do not count
+                break;
+            }
+
+            // idle workers get the oldest subproblems of the master, it keeps at least one for itself
+            if (++counter % CommFrequency == 0) {
+                auto worker = std::find_if(idleProcIds.begin(), idleProcIds.end(), [](int id) { return id != 0; });
+                while (LocalTaskQueue.size() > 1 && worker != idleProcIds.end()) {
+                    int id = *worker;
+                    idleProcIds.erase(worker);
+                    int PackSize = std::min(MaxPackageSize, (int) LocalTaskQueue.size() - 1);
+                    std::vector<Subproblem_Params> Package(LocalTaskQueue.begin(), LocalTaskQueue.begin() + PackSize);
+                    LocalTaskQueue.erase(LocalTaskQueue.begin(), LocalTaskQueue.begin() + PackSize);
+                    if (OpenRequests[id]) MPI_Wait(&req[id], MPI_STATUS_IGNORE);
+                    sendbuffer[id].Clear();
+                    encoder.Encode_Package(sendbuffer[id], Package);
+                    sendbuffer[id].Write(GlobalBestBound);
+                    MPI_Isend(sendbuffer[id].Data(), sendbuffer[id].Size(), MPI_CHAR, id,
+                              PtoP::MessageType::PROB, comm, &req[id]);
+                    OpenRequests[id] = true;
+                    stats.PackagesSent++;
+                    worker = std::find_if(idleProcIds.begin(), idleProcIds.end(), [](int id) { return id != 0; });
+                }
+            }
+            if (LocalTaskQueue.empty()) idleProcIds.push_back(0);
         }
-        // encode initial problem and empty sol into sendstream
-        sendstream[1] << 1 << " ";
-        encoder.Encode_Solution(sendstream[1], BestSubproblem);
-        sendstream[1] << GlobalBestBound << " ";
-        // send it to idle processor no. 1
-        MPI_Send(sendstream[1].str().c_str(), strlen(sendstream[1].str().c_str()), MPI_CHAR, 1,
-                 PtoP::MessageType::PROB, MPI_COMM_WORLD);
-        while (idleProcIds.size() != num - 1) {
-            MPI_Recv(buffer, 2000, MPI_CHAR, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+
+        for (int i = 1; i < num; i++) {
+            MPI_Send(nullptr, 0, MPI_CHAR, i, PtoP::MessageType::FINISH, comm);
+        }
+
+        // the workers received every message before FINISH, waiting keeps the buffers safe for the next search
+        for (int i = 1; i < num; i++)
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+        printProc("the master received a total of " << NumMessages << " messages and solved "
+                                                    << NumProblemsSolved << " problems");
+        return BestSubproblem;
+    }
+
+
+    // master that keeps a pool of the best open subproblems of the whole search, used by MasterWorker and Hybrid
+    // with GlobalPool. The pool is fed like an idle process: while it has room the master lists itself in the
+    // answer to a worker with more than one package of work, which then sends it a package. Idle processes get
+    // the best subproblems of the pool, only when it is empty they are given to the workers as usual
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params PoolMasterBehavior(std::vector<MPI_Buffer> &sendbuffer,
+                                         MPI_Buffer &receivbuffer,
+                                         const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                         const Prob_Consts &prob,
+                                         const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                                         const Goal goal,
+                                         const Domain_Type WorstBound,
+                                         Search_Control<Subproblem_Params, Domain_Type> &control,
+                                         MPI_Cancellation<Subproblem_Params, Domain_Type> &cancellation,
+                                         MPI_Search_Stats &stats,
+                                         const Domain_Type eps,
+                                         const int MaxPackageSize,
+                                         const int PoolSize,
+                                         const RampUp_Type ramp,
+                                         const int RampUpNodes,
+                                         MPI_Comm comm) {
+        int pid, num;
+        MPI_Comm_rank(comm, &pid);
+        MPI_Comm_size(comm, &num);
+        MPI_Status st;
+        std::vector<MPI_Request> req(num);
+        std::vector<bool> OpenRequests(num, false);
+
+        int NumMessages = 0;
+        int PackagesPooled = 0;
+        int PackagesFromPool = 0;
+        // packages that workers were told to send to the pool and that have not arrived yet
+        int Promised = 0;
+
+        Domain_Type GlobalBestBound = WorstBound;
+        Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+        std::vector<Subproblem_Params> ReceivedPackage;
+
+        // the estimate is kept next to the subproblem so it is computed only once
+        using Entry = std::pair<Domain_Type, Subproblem_Params>;
+        auto Compare = [goal](const Entry &a, const Entry &b) {
+            return (bool) goal ? a.first < b.first : a.first > b.first;
+        };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(Compare)> Pool(Compare);
+        auto IsPruned = [&](Domain_Type Estimate) {
+            return ((bool) goal && Estimate < GlobalBestBound) || (!(bool) goal && Estimate > GlobalBestBound);
+        };
+
+        std::vector<int> idleProcIds = DistributeInitialWork(sendbuffer, Problem_Def, prob, encoder, goal, eps, ramp,
+                                                             RampUpNodes, control, GlobalBestBound, BestSubproblem,
+                                                             comm);
+
+        // hands the best subproblems of the pool to idle processes, pruned ones are dropped on the way
+        auto ServeIdle = [&]() {
+            while (!Pool.empty() && !idleProcIds.empty()) {
+                std::vector<Subproblem_Params> Package;
+                while (!Pool.empty() && (int) Package.size() < MaxPackageSize) {
+                    if (!IsPruned(Pool.top().first)) Package.push_back(Pool.top().second);
+                    Pool.pop();
+                }
+                if (Package.empty()) break;
+                int id = idleProcIds.front();
+                idleProcIds.erase(idleProcIds.begin());
+                if (OpenRequests[id]) MPI_Wait(&req[id], MPI_STATUS_IGNORE);
+                sendbuffer[id].Clear();
+                encoder.Encode_Package(sendbuffer[id], Package);
+                sendbuffer[id].Write(GlobalBestBound);
+                MPI_Isend(sendbuffer[id].Data(), sendbuffer[id].Size(), MPI_CHAR, id,
+                          PtoP::MessageType::PROB, comm, &req[id]);
+                OpenRequests[id] = true;
+                PackagesFromPool++;
+                stats.PackagesSent++;
+            }
+        };
+
+        // a worker that was told to feed the pool may already be idle, so the promised packages are waited for
+        while ((int) idleProcIds.size() != num - 1 || !Pool.empty() || Promised > 0) {
+            cancellation.Wait(st);
+            ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, comm);
             NumMessages++;
-            receivstream.str(buffer);
             if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) {
                 int sl_needed;
                 int r = st.MPI_SOURCE;
 
                 Domain_Type CandidateBound;
-                receivstream >> CandidateBound;
-
+                receivbuffer.Read(CandidateBound);
                 if (((bool) goal && CandidateBound > GlobalBestBound) ||
                     (!(bool) goal && CandidateBound < GlobalBestBound)) {
                     GlobalBestBound = CandidateBound;
+                    control.BoundImproved(GlobalBestBound);
                 }
 
-                receivstream >> sl_needed;
-                int sl_given = std::min(sl_needed, (int) idleProcIds.size());;
-                sendstream[r].str("");
-                sendstream[r] << GlobalBestBound << " ";
-                sendstream[r] << sl_given << " ";
-
-                std::for_each(idleProcIds.begin(), idleProcIds.begin() + sl_given,
-                              [&sendstream, &r](const int &el) { sendstream[r] << el << " "; });
+                receivbuffer.Read(sl_needed);
+                // after a cancel no more work is spread, the workers empty their queues and become idle
+                std::vector<int> Given;
+                if (!cancellation.IsCancelled()) {
+                    Given.assign(idleProcIds.begin(), idleProcIds.begin() + std::min(sl_needed, (int) idleProcIds.size()));
+                    idleProcIds.erase(idleProcIds.begin(), idleProcIds.begin() + Given.size());
+                    if (Given.empty() && sl_needed > MaxPackageSize
+                        && (int) Pool.size() + (Promised + 1) * MaxPackageSize <= PoolSize) {
+                        Given.push_back(0);
+                        Promised++;
+                    }
+                }
+                // the last answer to r may still be in flight, its buffer can only be reused once it is sent
                 if (OpenRequests[r]) MPI_Wait(&req[r], MPI_STATUS_IGNORE);
-                MPI_Isend(&sendstream[r].str()[0], strlen(sendstream[r].str().c_str()), MPI_CHAR, r,
-                          PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD, &req[r]);
+                sendbuffer[r].Clear();
+                sendbuffer[r].Write(GlobalBestBound);
+                sendbuffer[r].Write((int) Given.size());
+                sendbuffer[r].Write(Given.data(), Given.size() * sizeof(int));
+                MPI_Isend(sendbuffer[r].Data(), sendbuffer[r].Size(), MPI_CHAR, r,
+                          PtoP::MessageType::GET_WORKERS, comm, &req[r]);
                 OpenRequests[r] = true;
-                idleProcIds.erase(idleProcIds.begin(), idleProcIds.begin() + sl_given);
             } else if (st.MPI_TAG == PtoP::MessageType::IDLE) {
                 //slave has become idle
                 idleProcIds.push_back(st.MPI_SOURCE);
+                if (!cancellation.IsCancelled()) ServeIdle();
+            } else if (st.MPI_TAG == PtoP::MessageType::PROB) {
+                // a package for the pool
+                Promised--;
+                PackagesPooled++;
+                stats.PackagesPooled++;
+                encoder.Decode_Package(receivbuffer, ReceivedPackage);
+                Domain_Type newBoundValue;
+                receivbuffer.Read(newBoundValue);
+                if (((bool) goal && newBoundValue > GlobalBestBound) ||
+                    (!(bool) goal && newBoundValue < GlobalBestBound)) {
+                    GlobalBestBound = newBoundValue;
+                    control.BoundImproved(GlobalBestBound);
+                }
+                for (auto &el : ReceivedPackage) {
+                    Domain_Type Estimate = std::get<0>(Problem_Def.GetEstimateForBounds(prob, el));
+                    if (!IsPruned(Estimate)) Pool.push({Estimate, std::move(el)});
+                }
+                stats.LargestPool = std::max(stats.LargestPool, (long long) Pool.size());
+                if (!cancellation.IsCancelled()) ServeIdle();
             }
+            // a cancelled search drops the pool
+            while (cancellation.IsCancelled() && !Pool.empty())
+                Pool.pop();
         }
 
         for (int i = 1; i < num; i++) {
-            MPI_Send(buffer, 1, MPI_CHAR, i, PtoP::MessageType::FINISH, MPI_COMM_WORLD);
+            MPI_Send(nullptr, 0, MPI_CHAR, i, PtoP::MessageType::FINISH, comm);
         }
 
+        // the workers received every message before FINISH, waiting keeps the buffers safe for the next search
         for (int i = 1; i < num; i++)
-            if (OpenRequests[i]) MPI_Request_free(&req[i]);
-        printProc("the master received a total of " << NumMessages << " messages");
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+        printProc("the master received a total of " << NumMessages << " messages, " << PackagesPooled
+                                                    << " packages went into the pool and " << PackagesFromPool
+                                                    << " out of it");
         return BestSubproblem;
     }
 
 
-    // after the algorithm has finished every processor has its local optimum, the global optimum has to be found
+    // after the algorithm has finished every processor has its local optimum, the global optimum has to be found.
+    // One reduction over (bound, rank) tells all processes the winner, only the winner then sends its solution to
+    // the master or, with ToAll, broadcasts it so that every process returns the global optimum
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
-    Subproblem_Params ExtractBestSolution(std::stringstream &sendstream, std::stringstream &receivstream,
+    Subproblem_Params ExtractBestSolution(MPI_Buffer &sendbuffer, MPI_Buffer &receivbuffer,
                                           Subproblem_Params BestSubproblem,
                                           const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                                           const Prob_Consts &prob,
                                           const MPI_Message_Encoder <Subproblem_Params> &encoder,
-                                          const Goal goal) {
-        int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
+                                          const Goal goal,
+                                          MPI_Comm comm,
+                                          const bool ToAll = false) {
+        int pid;
+        MPI_Comm_rank(comm, &pid);
         MPI_Status st;
-        if (pid == 0) { // master receives all solutions and compares them
-            char buf[10000];
-            Subproblem_Params GlobalSolution = BestSubproblem;
-            Domain_Type GlobalBound = Problem_Def.GetContainedUpperBound(prob, GlobalSolution);
-            for (int i = 1; i < num; i++) {
-                MPI_Recv(buf, 10000, MPI_CHAR, i, 999, MPI_COMM_WORLD, &st);
-                receivstream.str(buf);
-                Subproblem_Params Subproblem;
-                encoder.Decode_Solution(receivstream, Subproblem);
-                Domain_Type temp = Problem_Def.GetContainedUpperBound(prob, Subproblem);
-                if (((bool) goal && temp >= GlobalBound)
-                    || (!(bool) goal && temp <= GlobalBound)) {
-                    GlobalSolution = Subproblem;
-                    GlobalBound = temp;
-                }
+        // the bound keeps its own type, so the comparison is exact
+        Value_With_Rank<Domain_Type> Local{Problem_Def.GetContainedUpperBound(prob, BestSubproblem), pid}, Winner{};
+        MPI_Allreduce(&Local, &Winner, 1, ConvertTypeToMPIPairType<Domain_Type>(), (bool) goal ? MPI_MAXLOC : MPI_MINLOC,
+                      comm);
+
+        if (ToAll) {
+            int size = 0;
+            if (pid == Winner.Rank) {
+                sendbuffer.Clear();
+                encoder.Encode_Solution(sendbuffer, BestSubproblem);
+                size = sendbuffer.Size();
             }
-            Problem_Def.PrintSolution(GlobalSolution);
-            return GlobalSolution;
-        } else { // worker sends his solution
-            sendstream.str("");
-            encoder.Encode_Solution(sendstream, BestSubproblem);
-            MPI_Send(&sendstream.str()[0], strlen(sendstream.str().c_str()), MPI_CHAR, 0,
-                     999, MPI_COMM_WORLD);
-            return BestSubproblem;
+            MPI_Bcast(&size, 1, MPI_INT, Winner.Rank, comm);
+            // the root only reads its buffer
+            char *data = pid == Winner.Rank ? const_cast<char *>(sendbuffer.Data()) : receivbuffer.Receive(size);
+            MPI_Bcast(data, size, MPI_CHAR, Winner.Rank, comm);
+            if (pid != Winner.Rank)
+                encoder.Decode_Solution(receivbuffer, BestSubproblem);
+        } else if (Winner.Rank != 0 && pid == Winner.Rank) {
+            sendbuffer.Clear();
+            encoder.Encode_Solution(sendbuffer, BestSubproblem);
+            MPI_Send(sendbuffer.Data(), sendbuffer.Size(), MPI_CHAR, 0, Result::MessageType::SOLUTION, comm);
+        } else if (Winner.Rank != 0 && pid == 0) {
+            ReceiveMessage(receivbuffer, Winner.Rank, Result::MessageType::SOLUTION, st, comm);
+            encoder.Decode_Solution(receivbuffer, BestSubproblem);
         }
+
+        if (pid == 0)
+            Problem_Def.PrintSolution(BestSubproblem);
+        return BestSubproblem;
     }
 }
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "MPI_Scheduler_MasterWorker.h"
+
+namespace BnB {
+    namespace Hierarchy { // messages between the root and the sub-masters, the workers only use PtoP messages
+        enum MessageType {
+            GROUP_REQUEST = 5, // a sub-master wants idle groups (or only reports its bound if it wants none)
+            GROUP_ANSWER = 6,  // the root sends its bound and the sub-masters of idle groups
+            GROUP_IDLE = 7,    // a group became idle or hands back idle groups it could not use
+        };
+    }
+
+    // master worker with two levels of masters. The processes besides 0 are split into groups, the first process
+    // of a group is its sub-master and serves the GET_WORKERS and IDLE messages of the workers in its group
+    // like the master of MPI_Scheduler_MasterWorker does. Only if a group has no idle worker left the sub-master
+    // asks the root (process 0) for idle groups. It hands those out like its own workers, a package sent to a
+    // sub-master is passed on to one of its idle workers. The root only knows which groups are idle, the search
+    // is over once all of them are.
+    // With less than 3 processes there is no room for a sub-master, then it runs the flat MasterWorker
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    class MPI_Scheduler_Hierarchical : public MPI_Scheduler_MasterWorker<Prob_Consts, Subproblem_Params, Domain_Type> {
+    public:
+        Subproblem_Params Execute(const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                  const Prob_Consts &prob,
+                                  const MPI_Message_Encoder<Subproblem_Params> &encoder,
+                                  const Goal goal,
+                                  const Domain_Type WorstBound) override;
+
+        // minimal number of processes in a group including its sub-master, the groups are made equally big
+        MPI_Scheduler_Hierarchical<Prob_Consts, Subproblem_Params, Domain_Type> *GroupSize(int size) {
+            assert(size >= 2 && "a group needs a sub-master and a worker");
+            MinGroupSize = size;
+            return this;
+        }
+
+        // number of groups of the last search, 1 also if it ran the flat MasterWorker
+        int Groups() const { return NumGroups; }
+
+        // idle groups the root handed to busy groups in the last search, only counted on process 0
+        long long GroupsLent() const { return NumGroupsLent; }
+
+    private:
+        int MinGroupSize = 16;
+        int NumGroups = 1;
+        long long NumGroupsLent = 0;
+        int num = 0;
+
+        // first process of group g, which is its sub-master. Group g ends where group g + 1 starts
+        int GroupStart(int g) const { return 1 + g * (num - 1) / NumGroups; }
+
+        void Root(const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                  const Prob_Consts &prob,
+                  const MPI_Message_Encoder<Subproblem_Params> &encoder,
+                  const Goal goal,
+                  const Domain_Type WorstBound);
+
+        void SubMaster(const Goal goal, const Domain_Type WorstBound, int first, int last);
+
+        // sends a message to the root from sendbuffers[0], fill writes it once the previous one has left the buffer
+        template<typename Fill>
+        void SendToRoot(int tag, Fill &&fill) {
+            if (this->OpenRequests[0]) MPI_Wait(&this->req[0], MPI_STATUS_IGNORE);
+            this->sendbuffers[0].Clear();
+            fill(this->sendbuffers[0]);
+            MPI_Isend(this->sendbuffers[0].Data(), this->sendbuffers[0].Size(), MPI_CHAR, 0, tag, this->comm,
+                      &this->req[0]);
+            this->OpenRequests[0] = true;
+        }
+    };
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params MPI_Scheduler_Hierarchical<Prob_Consts, Subproblem_Params, Domain_Type>::Execute(
+            const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder<Subproblem_Params> &encoder,
+            const Goal goal,
+            const Domain_Type WorstBound) {
+        int pid;
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
+        NumGroups = 1;
+        NumGroupsLent = 0;
+        if (num < 3)
+            return MPI_Scheduler_MasterWorker<Prob_Consts, Subproblem_Params, Domain_Type>::Execute(
+                    Problem_Def, prob, encoder, goal, WorstBound);
+
+        // rounding down keeps every group at least MinGroupSize big
+        NumGroups = std::max(1, (num - 1) / MinGroupSize);
+        this->PrepareBuffers(num);
+        this->StartSearch(Problem_Def, prob, goal, WorstBound);
+
+        Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+        if (pid == 0) {
+            Root(Problem_Def, prob, encoder, goal, WorstBound);
+        } else {
+            int g = 0;
+            while (GroupStart(g + 1) <= pid) g++;
+            if (pid == GroupStart(g))
+                SubMaster(goal, WorstBound, pid, GroupStart(g + 1));
+            else
+                BestSubproblem = this->Work(Problem_Def, prob, encoder, goal, WorstBound, GroupStart(g));
+        }
+
+        this->FinishSearch();
+
+        // ------------------------ ALL procs have a best solution now master has to gather it
+        BestSubproblem = ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(this->sendbuffers[0],
+                                                                                          this->receivbuffer,
+                                                                                          BestSubproblem,
+                                                                                          Problem_Def,
+                                                                                          prob,
+                                                                                          encoder,
+                                                                                          goal,
+                                                                                          this->comm,
+                                                                                          this->BroadcastSolution);
+        if (pid == 0)
+            this->control->Improved(Problem_Def.GetContainedUpperBound(prob, BestSubproblem), BestSubproblem);
+        return BestSubproblem;
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    void MPI_Scheduler_Hierarchical<Prob_Consts, Subproblem_Params, Domain_Type>::Root(
+            const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder<Subproblem_Params> &encoder,
+            const Goal goal,
+            const Domain_Type WorstBound) {
+        auto &sendbuffers = this->sendbuffers;
+        auto &receivbuffer = this->receivbuffer;
+        auto &req = this->req;
+        auto &OpenRequests = this->OpenRequests;
+        MPI_Status st;
+        int NumMessages = 0;
+        Domain_Type GlobalBestBound = WorstBound;
+
+        // sub-masters of the idle groups, group 0 gets the initial problem
+        std::vector<int> IdleGroups;
+        for (int g = 1; g < NumGroups; g++)
+            IdleGroups.push_back(GroupStart(g));
+        sendbuffers[1].Clear();
+        encoder.Encode_Package(sendbuffers[1], {Problem_Def.GetInitialSubproblem(prob)});
+        sendbuffers[1].Write(GlobalBestBound);
+        MPI_Send(sendbuffers[1].Data(), sendbuffers[1].Size(), MPI_CHAR, 1, PtoP::MessageType::PROB, this->comm);
+
+        auto UpdateBound = [&](Domain_Type CandidateBound) {
+            if (((bool) goal && CandidateBound > GlobalBestBound) ||
+                (!(bool) goal && CandidateBound < GlobalBestBound)) {
+                GlobalBestBound = CandidateBound;
+                this->control->BoundImproved(GlobalBestBound);
+            }
+        };
+
+        while ((int) IdleGroups.size() != NumGroups) {
+            this->cancellation.Wait(st);
+            ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, this->comm);
+            NumMessages++;
+            int r = st.MPI_SOURCE;
+            if (st.MPI_TAG == Hierarchy::MessageType::GROUP_REQUEST) {
+                Domain_Type CandidateBound;
+                int needed;
+                receivbuffer.Read(CandidateBound);
+                receivbuffer.Read(needed);
+                UpdateBound(CandidateBound);
+                int given = this->cancellation.IsCancelled() ? 0 : std::min(needed, (int) IdleGroups.size());
+                if (OpenRequests[r]) MPI_Wait(&req[r], MPI_STATUS_IGNORE);
+                sendbuffers[r].Clear();
+                sendbuffers[r].Write(GlobalBestBound);
+                sendbuffers[r].Write(given);
+                sendbuffers[r].Write(IdleGroups.data(), given * sizeof(int));
+                MPI_Isend(sendbuffers[r].Data(), sendbuffers[r].Size(), MPI_CHAR, r,
+                          Hierarchy::MessageType::GROUP_ANSWER, this->comm, &req[r]);
+                OpenRequests[r] = true;
+                IdleGroups.erase(IdleGroups.begin(), IdleGroups.begin() + given);
+                NumGroupsLent += given;
+            } else if (st.MPI_TAG == Hierarchy::MessageType::GROUP_IDLE) {
+                Domain_Type CandidateBound;
+                int BecameIdle, returned;
+                receivbuffer.Read(CandidateBound);
+                receivbuffer.Read(BecameIdle);
+                receivbuffer.Read(returned);
+                UpdateBound(CandidateBound);
+                for (int i = 0; i < returned; i++) {
+                    int group;
+                    receivbuffer.Read(group);
+                    IdleGroups.push_back(group);
+                }
+                if (BecameIdle) IdleGroups.push_back(r);
+            }
+        }
+
+        for (int g = 0; g < NumGroups; g++)
+            MPI_Send(nullptr, 0, MPI_CHAR, GroupStart(g), PtoP::MessageType::FINISH, this->comm);
+        // every sub-master read its answers before it reported idle, so these complete
+        for (int i = 1; i < num; i++)
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+        printProc("the root received a total of " << NumMessages << " messages");
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    void MPI_Scheduler_Hierarchical<Prob_Consts, Subproblem_Params, Domain_Type>::SubMaster(
+            const Goal goal, const Domain_Type WorstBound, int first, int last) {
+        auto &sendbuffers = this->sendbuffers;
+        auto &receivbuffer = this->receivbuffer;
+        auto &req = this->req;
+        auto &OpenRequests = this->OpenRequests;
+        MPI_Status st;
+        int NumMessages = 0;
+        Domain_Type GroupBestBound = WorstBound;
+
+        std::vector<int> IdleWorkers;
+        for (int i = first + 1; i < last; i++)
+            IdleWorkers.push_back(i);
+        const int GroupWorkers = last - first - 1;
+        // sub-masters of idle groups the root gave to this group
+        std::vector<int> IdleGroups;
+        bool GroupBusy = false;
+        bool RequestOngoing = false;
+        // the root has not heard of the group's bound yet
+        bool NewBound = false;
+
+        auto Request = [&](int needed) {
+            SendToRoot(Hierarchy::MessageType::GROUP_REQUEST, [&](MPI_Buffer &buffer) {
+                buffer.Write(GroupBestBound);
+                buffer.Write(needed);
+            });
+            RequestOngoing = true;
+            NewBound = false;
+        };
+        auto ReportIdle = [&](int BecameIdle) {
+            SendToRoot(Hierarchy::MessageType::GROUP_IDLE, [&](MPI_Buffer &buffer) {
+                buffer.Write(GroupBestBound);
+                buffer.Write(BecameIdle);
+                buffer.Write((int) IdleGroups.size());
+                buffer.Write(IdleGroups.data(), IdleGroups.size() * sizeof(int));
+            });
+            IdleGroups.clear();
+            NewBound = false;
+        };
+        auto UpdateBound = [&](Domain_Type CandidateBound) {
+            if (((bool) goal && CandidateBound > GroupBestBound) ||
+                (!(bool) goal && CandidateBound < GroupBestBound)) {
+                GroupBestBound = CandidateBound;
+                this->control->BoundImproved(GroupBestBound);
+                return true;
+            }
+            return false;
+        };
+
+        while (true) {
+            this->cancellation.Wait(st);
+            ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, this->comm);
+            NumMessages++;
+            int r = st.MPI_SOURCE;
+            if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) {
+                Domain_Type CandidateBound;
+                int sl_needed;
+                receivbuffer.Read(CandidateBound);
+                receivbuffer.Read(sl_needed);
+                NewBound |= UpdateBound(CandidateBound);
+                if (this->cancellation.IsCancelled()) sl_needed = 0;
+                // own workers first, they are the closest
+                int local = std::min(sl_needed, (int) IdleWorkers.size());
+                int remote = std::min(sl_needed - local, (int) IdleGroups.size());
+                if (OpenRequests[r]) MPI_Wait(&req[r], MPI_STATUS_IGNORE);
+                sendbuffers[r].Clear();
+                sendbuffers[r].Write(GroupBestBound);
+                sendbuffers[r].Write(local + remote);
+                sendbuffers[r].Write(IdleWorkers.data(), local * sizeof(int));
+                sendbuffers[r].Write(IdleGroups.data(), remote * sizeof(int));
+                MPI_Isend(sendbuffers[r].Data(), sendbuffers[r].Size(), MPI_CHAR, r,
+                          PtoP::MessageType::GET_WORKERS, this->comm, &req[r]);
+                OpenRequests[r] = true;
+                IdleWorkers.erase(IdleWorkers.begin(), IdleWorkers.begin() + local);
+                IdleGroups.erase(IdleGroups.begin(), IdleGroups.begin() + remote);
+
+                // only the deficit and new bounds go up to the root
+                if (!RequestOngoing && sl_needed > local + remote)
+                    Request(sl_needed - local - remote);
+                else if (!RequestOngoing && NewBound)
+                    Request(0);
+            } else if (st.MPI_TAG == PtoP::MessageType::IDLE) {
+                IdleWorkers.push_back(r);
+            } else if (st.MPI_TAG == PtoP::MessageType::PROB) {
+                // the root gave this group to someone while it was idle, so one of its workers is idle
+                assert(!IdleWorkers.empty() && "a package reached a group without idle workers");
+                int w = IdleWorkers.back();
+                IdleWorkers.pop_back();
+                if (OpenRequests[w]) MPI_Wait(&req[w], MPI_STATUS_IGNORE);
+                sendbuffers[w].Clear();
+                sendbuffers[w].Write(receivbuffer.Data(), receivbuffer.Size());
+                MPI_Isend(sendbuffers[w].Data(), sendbuffers[w].Size(), MPI_CHAR, w,
+                          PtoP::MessageType::PROB, this->comm, &req[w]);
+                OpenRequests[w] = true;
+                GroupBusy = true;
+            } else if (st.MPI_TAG == Hierarchy::MessageType::GROUP_ANSWER) {
+                RequestOngoing = false;
+                Domain_Type RootsBound;
+                int given;
+                receivbuffer.Read(RootsBound);
+                receivbuffer.Read(given);
+                UpdateBound(RootsBound);
+                for (int i = 0; i < given; i++) {
+                    int group;
+                    receivbuffer.Read(group);
+                    IdleGroups.push_back(group);
+                }
+            } else if (st.MPI_TAG == PtoP::MessageType::FINISH) {
+                for (int i = first + 1; i < last; i++)
+                    MPI_Send(nullptr, 0, MPI_CHAR, i, PtoP::MessageType::FINISH, this->comm);
+                break;
+            }
+
+            // the root has to know when the group runs dry, an idle group gives back what it could not use
+            if (GroupBusy && (int) IdleWorkers.size() == GroupWorkers) {
+                GroupBusy = false;
+                ReportIdle(1);
+            } else if (!GroupBusy && !IdleGroups.empty()) {
+                ReportIdle(0);
+            }
+        }
+
+        for (int i = 0; i < num; i++)
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+        printProc("the sub-master received a total of " << NumMessages << " messages");
+    }
+}
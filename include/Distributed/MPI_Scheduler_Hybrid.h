@@ -1,11 +1,21 @@
 #pragma once
 #include "MPI_Scheduler.h"
+#include "Incumbent.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 namespace BnB {
+    // master worker where every worker runs Threads() compute threads on one shared queue for the whole search.
+    // An extra thread of the worker does all the communication while the others compute: it asks the master for
+    // idle processes, sends them work from the queue and exchanges bounds. If the runtime grants only one thread,
+    // that thread computes between its communication steps. Only the thread that called Execute
+    // calls MPI, so MPI has to be initialized with at least MPI_THREAD_FUNNELED
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
     class MPI_Scheduler_Hybrid : public MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> {
     public:
-
+        MPI_Scheduler_Hybrid() { omp_init_lock(&QueueLock); }
+        ~MPI_Scheduler_Hybrid() override { omp_destroy_lock(&QueueLock); }
 
         Subproblem_Params Execute(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                                   const Prob_Consts &prob,
@@ -13,10 +23,47 @@ namespace BnB {
                                   const Goal goal,
                                   const Domain_Type WorstBound) override;
 
+        // number of compute threads per worker, the communication thread comes on top
         MPI_Scheduler_Hybrid<Prob_Consts, Subproblem_Params, Domain_Type> *Threads(size_t num) {OpenMPThreads = num; return this;}
 
     private:
+        // the loop of a compute thread, it takes subproblems from the queue until the worker is finished.
+        // Once the queue stayed empty for IdleSpins tries it sleeps between the tries
+        void Compute(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                     const Prob_Consts &prob);
+
+        // solves one subproblem from the queue, false if the queue was empty
+        bool Step(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                  const Prob_Consts &prob);
+
+        // the loop of the communication thread, returns once the master sent FINISH.
+        // Alone means there are no compute threads, then it solves a subproblem after every communication step
+        void Communicate(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                         const Prob_Consts &prob,
+                         const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                         bool Alone);
+
+        // sends a package from the front of the queue (or an empty one) to every process the master answered with
+        void ShareWork(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                       const Prob_Consts &prob,
+                       const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                       bool Empty);
+
         int OpenMPThreads = 1;
+        // same as in MPI_Cancellation::Wait
+        static constexpr int IdleSpins = 1000;
+        static constexpr int IdleSleepMicroseconds = 50;
+
+        // state of a worker shared by its threads, the queue is guarded by QueueLock
+        std::deque<Subproblem_Params> LocalTaskQueue;
+        omp_lock_t QueueLock;
+        // compute threads that work on a subproblem they took from the queue, changed under QueueLock so that
+        // an empty queue with no busy thread means there is no work left
+        int Busy = 0;
+        std::atomic<bool> Finished{false};
+        std::atomic<int> TasksDone{0};
+        Atomic_Incumbent<Subproblem_Params, Domain_Type> incumbent;
+        std::atomic<bool> FoundSolution{false};
     };
 
 
@@ -28,244 +75,301 @@ namespace BnB {
             const Goal goal,
             const Domain_Type WorstBound) {
         int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
         assert(num >= 2 && "this implementation needs at least 3 cores");
-        MPI_Status st;
-        MPI_Request SlaveReq;
-        std::vector<MPI_Request> req(num);
-        std::vector<bool> OpenRequests(num, false);
-        bool RequestOngoing = false;
-        int TasksDone = 0;
-
-        omp_lock_t QueueLock;
-        omp_init_lock(&QueueLock);
+        this->PrepareBuffers(num);
+        this->StartSearch(Problem_Def, prob, goal, WorstBound);
 
-        std::vector<std::stringstream> sendstreams(num);
-        for (auto &stream : sendstreams)
-            stream << std::setprecision(15);
-        std::stringstream receivstream("");
-        receivstream << std::setprecision(15);
         Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
 
-
         if (pid == 0) {
             printProc("threads: " << this->OpenMPThreads)
-            ///BestSubproblem = SplittingMasterBehavior(sendstreams, receivstream, Problem_Def, prob, encoder, goal, WorstBound);
-            BestSubproblem = DefaultMasterBehavior(sendstreams, receivstream, Problem_Def, prob, encoder, goal, WorstBound);
+            if (this->PoolSize > 0)
+                BestSubproblem = PoolMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob,
+                                                    encoder, goal, WorstBound, *this->control, this->cancellation,
+                                                    this->stats, this->eps, this->MaxPackageSize, this->PoolSize,
+                                                    this->Ramp, this->RampUpNodes, this->comm);
+            else if (this->MasterWorks)
+                BestSubproblem = WorkingMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob,
+                                                       encoder, goal, WorstBound, *this->control, this->cancellation,
+                                                       this->stats, this->mode, this->eps, this->MaxPackageSize,
+                                                       this->Communication_Frequency, this->Ramp, this->RampUpNodes,
+                                                       this->comm);
+            else
+                BestSubproblem = DefaultMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob,
+                                                       encoder, goal, WorstBound, *this->control, this->cancellation,
+                                                       this->stats, this->eps, this->Ramp, this->RampUpNodes, this->comm);
         } else { // Worker
-            char buffer[20000];
-            // local variables of
-            std::deque<Subproblem_Params> LocalTaskQueue;
-            Domain_Type LocalBestBound = WorstBound;
-            int counter = 0;
-
-            while (true) {
-                MPI_Recv(buffer, 20000, MPI_CHAR, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
-                receivstream.str(buffer);
-                if (st.MPI_TAG == PtoP::MessageType::PROB) {
-                    int NumOfProblems;
-                    receivstream >> NumOfProblems;
-                    for (int i = 0; i < NumOfProblems; i++) {
-                        Subproblem_Params Received_Params;
-                        encoder.Decode_Solution(receivstream, Received_Params);
-                        LocalTaskQueue.push_back(Received_Params);
-                    }
+            LocalTaskQueue.clear();
+            Busy = 0;
+            Finished = false;
+            TasksDone = 0;
+            incumbent.Reset(goal, WorstBound);
+            FoundSolution = false;
+            // a racing ramp-up starts with the own share of the first subproblems instead of a package
+            if (this->Ramp == RampUp_Type::RACING) {
+                Domain_Type RampUpBound = WorstBound;
+                Subproblem_Params RampUpBest = BestSubproblem;
+                LocalTaskQueue = ShareOf(ExpandBreadthFirst(Problem_Def, prob, goal, this->eps,
+                                                            this->RampUpNodes * (num - 1), *this->control,
+                                                            RampUpBound, RampUpBest), pid - 1, num - 1);
+                if (RampUpBound != WorstBound && incumbent.Offer(RampUpBound, RampUpBest))
+                    FoundSolution = true;
+                this->stats.RampUpShare = (long long) LocalTaskQueue.size();
+            }
+
+            // thread 0 is the thread that called Execute, it is the only one that uses MPI
+#pragma omp parallel num_threads(this->OpenMPThreads + 1)
+            {
+                if (omp_get_thread_num() == 0)
+                    Communicate(Problem_Def, prob, encoder, omp_get_num_threads() == 1);
+                else
+                    Compute(Problem_Def, prob);
+            }
+
+            if (FoundSolution) BestSubproblem = incumbent.Solution();
+            this->stats.Solved = TasksDone;
+            printProc("I have done " << TasksDone)
+        }
+
+        this->FinishSearch();
+
+        // ------------------------ ALL procs have a best solution now master has to gather it
+        BestSubproblem = ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(this->sendbuffers[0],
+                                                                                          this->receivbuffer,
+                                                                                          BestSubproblem,
+                                                                                          Problem_Def,
+                                                                                          prob,
+                                                                                          encoder,
+                                                                                          goal,
+                                                                                          this->comm,
+                                                                                          this->BroadcastSolution);
+        if (pid == 0)
+            this->control->Improved(Problem_Def.GetContainedUpperBound(prob, BestSubproblem), BestSubproblem);
+        return BestSubproblem;
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    void MPI_Scheduler_Hybrid<Prob_Consts, Subproblem_Params, Domain_Type>::Compute(
+            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob) {
+        for (int Empty = 0; !Finished; ) {
+            if (Step(Problem_Def, prob)) {
+                Empty = 0;
+                continue;
+            }
+            // the communication thread fills the queue again or ends the search
+            if (++Empty > IdleSpins)
+                std::this_thread::sleep_for(std::chrono::microseconds(IdleSleepMicroseconds));
+            else
+                std::this_thread::yield();
+        }
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    bool MPI_Scheduler_Hybrid<Prob_Consts, Subproblem_Params, Domain_Type>::Step(
+            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob) {
+        Subproblem_Params sol;
+        omp_set_lock(&QueueLock);
+        if (LocalTaskQueue.empty()) {
+            omp_unset_lock(&QueueLock);
+            return false;
+        }
+        sol = GetNextSubproblem(LocalTaskQueue, this->mode);
+        Busy++;
+        omp_unset_lock(&QueueLock);
+        TasksDone++;
+
+        std::vector<Subproblem_Params> v;
+        //ignore if its bound is worse than already known best sol.
+        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+        if (!incumbent.IsPruned(LowerBound) && !this->control->IsCancelled()) {
+            // try to make the bound better
+            auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+            Domain_Type CandidateBound = UpperBound;
+            if (Feasibility == BnB::FEASIBILITY::Full) {
+                CandidateBound = Problem_Def.GetContainedUpperBound(prob, sol);
+                if (incumbent.Offer(CandidateBound, sol)) {
+                    FoundSolution = true;
+                    this->control->Improved(CandidateBound, sol);
+                }
+            }
 
+            // check if we cant divide further
+            if (Feasibility != BnB::FEASIBILITY::NONE && std::abs(CandidateBound - LowerBound) > this->eps) {
+                for (auto &&el : Problem_Def.SplitSolution(prob, sol)) {
+                    auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, el);
+                    if (!incumbent.IsPruned(Lower))
+                        v.push_back(std::move(el));
+                }
+            }
+        }
+
+        omp_set_lock(&QueueLock);
+        std::move(v.begin(), v.end(), std::back_inserter(LocalTaskQueue));
+        Busy--;
+        omp_unset_lock(&QueueLock);
+        return true;
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    void MPI_Scheduler_Hybrid<Prob_Consts, Subproblem_Params, Domain_Type>::Communicate(
+            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder <Subproblem_Params> &encoder,
+            bool Alone) {
+        auto &receivbuffer = this->receivbuffer;
+        auto &req = this->req;
+        auto &OpenRequests = this->OpenRequests;
+        MPI_Status st;
+        this->channel.Start(0, PtoP::MessageType::GET_WORKERS, PtoP::MessageType::IDLE, this->comm);
+        MPI_Request &SlaveReq = this->channel.Pending();
+        bool RequestOngoing = false;
+        // a racing worker starts with work, it reports idle as usual once its share is done
+        bool HasWork = this->Ramp == RampUp_Type::RACING;
+        int LastRequest = 0;
+        std::vector<Subproblem_Params> ReceivedPackage;
+
+        auto TakeMastersAnswer = [&](bool Empty) {
+            RequestOngoing = false;
+            this->pace.Answered();
+            Domain_Type MastersBound;
+            receivbuffer.Read(MastersBound);
+            incumbent.OfferBound(MastersBound);
+            ShareWork(Problem_Def, prob, encoder, Empty);
+        };
+
+        while (true) {
+            if (!HasWork) {
+                // nothing to compute, wait for the next message
+                this->cancellation.Wait(st);
+                ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, this->comm);
+                if (st.MPI_TAG == PtoP::MessageType::PROB) {
+                    encoder.Decode_Package(receivbuffer, ReceivedPackage);
+                    // the first package is the share of the ramp-up
+                    if (this->Ramp == RampUp_Type::MASTER_BFS && TasksDone == 0)
+                        this->stats.RampUpShare = (long long) ReceivedPackage.size();
                     Domain_Type newBoundValue;
-                    receivstream >> newBoundValue;
+                    receivbuffer.Read(newBoundValue);
                     // the new work package comes with a bound, check if the bound is better
-                    if (((bool) goal && newBoundValue >= LocalBestBound)
-                        || (!(bool) goal && newBoundValue <= LocalBestBound)) {
-                        LocalBestBound = newBoundValue;
-                    }
-
-                    while (!LocalTaskQueue.empty()) {
-                        counter = 1;
-                        int dynamicThreads = std::min(this->OpenMPThreads, (int) LocalTaskQueue.size());
-#pragma omp parallel num_threads(dynamicThreads)  shared(LocalBestBound, LocalTaskQueue, BestSubproblem, counter)
-                        {
-                            while (counter % this->Communication_Frequency != 0) {
-                                #pragma omp atomic
-                                counter = counter + 1;
-                                #pragma omp atomic
-                                TasksDone = TasksDone + 1;
-
-                                Subproblem_Params sol;
-                                bool isEmpty = false;
-                                omp_set_lock(&QueueLock);
-                                isEmpty = LocalTaskQueue.empty();
-                                if (!isEmpty) {
-                                    sol = GetNextSubproblem(LocalTaskQueue, this->mode);
-                                }
-                                omp_unset_lock(&QueueLock);
-                                if (isEmpty)
-                                    break;
-
-                                //ignore if its bound is worse than already known best sol.
-                                auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
-                                if (((bool) goal && LowerBound < LocalBestBound)
-                                    || (!(bool) goal && LowerBound > LocalBestBound)) {
-                                    continue;
-                                }
-                                // try to make the bound better
-                                auto Feasibility = Problem_Def.IsFeasible(prob, sol);
-                                Domain_Type CandidateBound;
-                                if (Feasibility == BnB::FEASIBILITY::Full) {
-                                    CandidateBound = Problem_Def.GetContainedUpperBound(prob, sol);
-#pragma omp critical
-                                    {
-                                        if (((bool) goal && CandidateBound >= LocalBestBound)
-                                            || (!(bool) goal && CandidateBound <= LocalBestBound)) {
-                                            LocalBestBound = CandidateBound;
-                                            BestSubproblem = sol;
-                                        }
-                                    }
-                                } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
-                                    CandidateBound = UpperBound;
-                                } else if (Feasibility == BnB::FEASIBILITY::NONE)
-                                    continue;
-
-
-                                // check if we cant divide further
-                                if (std::abs(CandidateBound - LowerBound) > this->eps) {
-                                    std::vector<Subproblem_Params> v;
-                                    v = Problem_Def.SplitSolution(prob, sol);
-                                    for (auto &&el : v) {
-                                        auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, el);
-                                        if (((bool) goal && Lower < LocalBestBound)
-                                            || (!(bool) goal && Lower > LocalBestBound)) {
-                                            continue;
-                                        }
-                                        omp_set_lock(&QueueLock);
-                                        LocalTaskQueue.push_back(el);
-                                        omp_unset_lock(&QueueLock);
-                                    }
-                                }
-                            }
-#pragma omp barrier
-                        }
-
-                        if (!RequestOngoing && !LocalTaskQueue.empty()) {
-                            sendstreams[0].str("");
-                            sendstreams[0] << LocalBestBound << " ";
-                            sendstreams[0] << (int) LocalTaskQueue.size() << " ";
-                            MPI_Isend(&sendstreams[0].str()[0], strlen(sendstreams[0].str().c_str()), MPI_CHAR, 0,
-                                      PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD, &SlaveReq);
-                            RequestOngoing = true;
-                        }
-
-                        if (RequestOngoing) {
-                            int flag = 0;
-                            MPI_Test(&SlaveReq, &flag, MPI_STATUS_IGNORE);
-                            if (flag == 1) {
-                                RequestOngoing = false;
-                                //get master's response
-                                MPI_Recv(buffer, 20000, MPI_CHAR, 0, PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD,
-                                         &st);
-                                receivstream.str(buffer);
-                                int slaves_avbl;
-                                Domain_Type MastersBound;
-                                receivstream >> MastersBound;
-
-                                if (((bool) goal && MastersBound >= LocalBestBound)
-                                    || (!(bool) goal && MastersBound <= LocalBestBound)) {
-                                    LocalBestBound = MastersBound;
-                                }
-
-                                receivstream >> slaves_avbl;
-
-                                for (int i = 0; i < slaves_avbl; i++) {
-                                    //give a problem to each slave
-                                    int sl_no;
-                                    receivstream >> sl_no;
-                                    int RestSize = std::min(this->MaxPackageSize, (int) LocalTaskQueue.size());
-                                    std::vector<Subproblem_Params> SubproblemsToSend;
-                                    while (!LocalTaskQueue.empty() and SubproblemsToSend.size() != RestSize) {
-                                        Subproblem_Params subprb = LocalTaskQueue.front();
-                                        LocalTaskQueue.pop_front();
-                                        auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, subprb);
-                                        if (((bool) goal && Lower < LocalBestBound)
-                                            || (!(bool) goal && Lower > LocalBestBound)) {
-                                            continue;
-                                        }
-                                        SubproblemsToSend.push_back(subprb);
-                                    }
-
-                                    sendstreams[sl_no].str("");
-                                    sendstreams[sl_no] << static_cast<int>(SubproblemsToSend.size()) << " ";
-                                    for (auto &&subproblem : SubproblemsToSend)
-                                        encoder.Encode_Solution(sendstreams[sl_no], subproblem);
-                                    sendstreams[sl_no] << LocalBestBound << " ";
-                                    //send it to idle processor
-                                    if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
-                                    MPI_Isend(&sendstreams[sl_no].str()[0], strlen(sendstreams[sl_no].str().c_str()),
-                                              MPI_CHAR, sl_no,
-                                              PtoP::MessageType::PROB, MPI_COMM_WORLD, &req[sl_no]);
-                                    OpenRequests[sl_no] = true;
-                                }
-                            }
-                        }
-
-                    }
-
-                    //This slave has now become idle (its queue is empty). Inform master.
-                    sendstreams[0].str("");
-                    MPI_Ssend(&sendstreams[0].str()[0], 0, MPI_CHAR, 0, PtoP::MessageType::IDLE, MPI_COMM_WORLD);
+                    incumbent.OfferBound(newBoundValue);
+                    omp_set_lock(&QueueLock);
+                    std::move(ReceivedPackage.begin(), ReceivedPackage.end(), std::back_inserter(LocalTaskQueue));
+                    omp_unset_lock(&QueueLock);
+                    HasWork = true;
+                    LastRequest = TasksDone;
+                    this->pace.Resume(TasksDone);
                 } else if (st.MPI_TAG == PtoP::MessageType::FINISH) {
                     break;
                 } else if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) {
-                    RequestOngoing = false;
+                    // the master answered so it has the request, this completes at once
+                    MPI_Wait(&SlaveReq, MPI_STATUS_IGNORE);
+                    TakeMastersAnswer(true);
+                }
+                continue;
+            }
+
+            // a cancelled search drops its open nodes, the worker then reports idle as usual
+            bool Cancelled = this->cancellation.Check();
+            omp_set_lock(&QueueLock);
+            if (Cancelled) LocalTaskQueue.clear();
+            bool Working = !LocalTaskQueue.empty() || Busy > 0;
+            int QueueSize = LocalTaskQueue.size();
+            omp_unset_lock(&QueueLock);
+
+            if (!Working) {
+                //This slave has now become idle (its queue is empty). Inform master.
+                this->channel.Idle();
+                HasWork = false;
+                continue;
+            }
+
+            // bound and request for idle processes once every Frequency() subproblems of all compute threads
+            if (TasksDone - LastRequest >= this->pace.Frequency()) {
+                LastRequest = TasksDone;
+                this->pace.Communicated(LastRequest);
+                Domain_Type LocalBestBound = incumbent.Bound();
+                this->ShareBound(LocalBestBound);
+                incumbent.OfferBound(LocalBestBound);
+                this->TestSends();
+                if (!RequestOngoing && QueueSize > 0) {
+                    this->channel.Request(LocalBestBound, QueueSize);
+                    this->pace.Sent();
+                    RequestOngoing = true;
+                }
+            }
+
+            if (RequestOngoing) {
+                int flag = 0;
+                MPI_Test(&SlaveReq, &flag, MPI_STATUS_IGNORE);
+                if (flag == 1) {
                     //get master's response
-                    int slaves_avbl;
-                    Domain_Type MastersBound;
-                    receivstream >> MastersBound;
-
-                    if (((bool) goal && MastersBound >= LocalBestBound)
-                        || (!(bool) goal && MastersBound <= LocalBestBound)) {
-                        LocalBestBound = MastersBound;
-                    }
-
-                    receivstream >> slaves_avbl;
-
-                    for (int i = 0; i < slaves_avbl; i++) {
-                        //give a problem to each slave
-                        int sl_no;
-                        receivstream >> sl_no;
-
-                        sendstreams[sl_no].str("");
-                        sendstreams[sl_no] << 0 << " ";
-                        //send it to idle processor
-                        sendstreams[sl_no] << LocalBestBound << " ";
-                        if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
-                        MPI_Isend(&sendstreams[sl_no].str()[0], strlen(sendstreams[sl_no].str().c_str()), MPI_CHAR,
-                                  sl_no,
-                                  PtoP::MessageType::PROB, MPI_COMM_WORLD, &req[sl_no]);
-                        OpenRequests[sl_no] = true;
-                    }
+                    ReceiveMessage(receivbuffer, 0, PtoP::MessageType::GET_WORKERS, st, this->comm);
+                    TakeMastersAnswer(false);
                 }
             }
+            if (Alone)
+                Step(Problem_Def, prob);
+            else
+                std::this_thread::yield();
         }
 
-        omp_destroy_lock(&QueueLock);
+        // the compute threads leave their loop
+        Finished = true;
+
+        // the master only finishes once every message was received so all sends are complete.
+        // Waiting instead of freeing keeps the buffers safe for the next search
+        this->channel.Finish();
+        for (int i = 0; i < (int) OpenRequests.size(); i++)
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+    }
 
 
-        printProc("I have done " << TasksDone)
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    void MPI_Scheduler_Hybrid<Prob_Consts, Subproblem_Params, Domain_Type>::ShareWork(
+            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder <Subproblem_Params> &encoder,
+            bool Empty) {
+        auto &sendbuffers = this->sendbuffers;
+        auto &receivbuffer = this->receivbuffer;
+        auto &req = this->req;
+        auto &OpenRequests = this->OpenRequests;
+        int slaves_avbl;
+        receivbuffer.Read(slaves_avbl);
+        for (int i = 0; i < slaves_avbl; i++) {
+            //give a problem to each slave
+            int sl_no;
+            receivbuffer.Read(sl_no);
+            std::vector<Subproblem_Params> SubproblemsToSend;
+            if (!Empty) {
+                omp_set_lock(&QueueLock);
+                int RestSize = std::min(this->PackageSizeFor(sl_no, (int) LocalTaskQueue.size()),
+                                        (int) LocalTaskQueue.size());
+                while (!LocalTaskQueue.empty() and SubproblemsToSend.size() != RestSize) {
+                    Subproblem_Params subprb = LocalTaskQueue.front();
+                    LocalTaskQueue.pop_front();
+                    auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, subprb);
+                    if (incumbent.IsPruned(Lower)) continue;
+                    SubproblemsToSend.push_back(subprb);
+                }
+                omp_unset_lock(&QueueLock);
+            }
 
-        if (pid != 0) {
-            if (RequestOngoing)
-                MPI_Request_free(&SlaveReq);
-            for (int i = 1; i < num; i++)
-                if (OpenRequests[i]) MPI_Request_free(&req[i]);
+            if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
+            sendbuffers[sl_no].Clear();
+            encoder.Encode_Package(sendbuffers[sl_no], SubproblemsToSend);
+            sendbuffers[sl_no].Write(incumbent.Bound());
+            //send it to idle processor
+            MPI_Isend(sendbuffers[sl_no].Data(), sendbuffers[sl_no].Size(), MPI_CHAR, sl_no,
+                      PtoP::MessageType::PROB, this->comm, &req[sl_no]);
+            OpenRequests[sl_no] = true;
+            if (!SubproblemsToSend.empty()) this->stats.PackagesSent++;
         }
-        // ------------------------ ALL procs have a best solution now master has to gather it
-        return ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(sendstreams[0], receivstream,
-                                                                                BestSubproblem,
-                                                                                Problem_Def,
-                                                                                prob,
-                                                                                encoder,
-                                                                                goal);
     }
-
-
 }
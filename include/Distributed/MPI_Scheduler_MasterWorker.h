@@ -12,6 +12,16 @@ namespace BnB {
                                   const MPI_Message_Encoder<Subproblem_Params> &encoder,
                                   const Goal goal,
                                   const Domain_Type WorstBound) override;
+
+    protected:
+        // the worker side, Master hands out idle processes and gets the IDLE messages.
+        // Returns the best solution found by this worker
+        Subproblem_Params Work(const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                               const Prob_Consts &prob,
+                               const MPI_Message_Encoder<Subproblem_Params> &encoder,
+                               const Goal goal,
+                               const Domain_Type WorstBound,
+                               const int Master);
     };
 
 
@@ -47,219 +57,278 @@ namespace BnB {
             const MPI_Message_Encoder<Subproblem_Params> &encoder,
             const Goal goal,
             const Domain_Type WorstBound) {
-        bool RequestOngoing = false;
         int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
         assert(num >= 2 && "this implementation needs at least 3 cores");
-        MPI_Status st;
-        MPI_Request SlaveReq;
-        std::vector<MPI_Request> req(num);
-        std::vector<bool> OpenRequests(num, false);
+        this->PrepareBuffers(num);
+        this->StartSearch(Problem_Def, prob, goal, WorstBound);
+
+        Subproblem_Params BestSubproblem;
+        if (pid == 0 && this->PoolSize > 0) {
+            BestSubproblem = PoolMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob, encoder,
+                                                goal, WorstBound, *this->control, this->cancellation, this->stats,
+                                                this->eps, this->MaxPackageSize, this->PoolSize, this->Ramp,
+                                                this->RampUpNodes, this->comm);
+        } else if (pid == 0 && this->MasterWorks) {
+            BestSubproblem = WorkingMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob, encoder,
+                                                   goal, WorstBound, *this->control, this->cancellation, this->stats,
+                                                   this->mode, this->eps, this->MaxPackageSize,
+                                                   this->Communication_Frequency, this->Ramp, this->RampUpNodes,
+                                                   this->comm);
+        } else if (pid == 0) {
+            BestSubproblem = DefaultMasterBehavior(this->sendbuffers, this->receivbuffer, Problem_Def, prob, encoder, goal,
+                                                   WorstBound, *this->control, this->cancellation, this->stats,
+                                                   this->eps, this->Ramp, this->RampUpNodes, this->comm);
+        } else {
+            BestSubproblem = Work(Problem_Def, prob, encoder, goal, WorstBound, 0);
+        }
+
+        this->FinishSearch();
 
-        std::vector<std::stringstream> sendstreams(num);
-        for (auto &stream : sendstreams)
-            stream << std::setprecision(15);
-        std::stringstream receivstream("");
-        receivstream << std::setprecision(15);
+        // ------------------------ ALL procs have a best solution now master has to gather it
+        BestSubproblem = ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(this->sendbuffers[0],
+                                                                                          this->receivbuffer,
+                                                                                          BestSubproblem,
+                                                                                          Problem_Def,
+                                                                                          prob,
+                                                                                          encoder,
+                                                                                          goal,
+                                                                                          this->comm,
+                                                                                          this->BroadcastSolution);
+        if (pid == 0)
+            this->control->Improved(Problem_Def.GetContainedUpperBound(prob, BestSubproblem), BestSubproblem);
+        return BestSubproblem;
+    }
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params MPI_Scheduler_MasterWorker<Prob_Consts, Subproblem_Params, Domain_Type>::Work(
+            const Problem_Definition<Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder<Subproblem_Params> &encoder,
+            const Goal goal,
+            const Domain_Type WorstBound,
+            const int Master) {
+        bool RequestOngoing = false;
+        int pid, num;
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
+        MPI_Status st;
+        auto &req = this->req;
+        auto &OpenRequests = this->OpenRequests;
+        auto &sendbuffers = this->sendbuffers;
+        auto &receivbuffer = this->receivbuffer;
 
         Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
         int NumProblemsSolved = 0;
         int ProblemsEliminated = 0;
 
-        if (pid == 0) {
-            BestSubproblem = DefaultMasterBehavior(sendstreams, receivstream, Problem_Def, prob, encoder, goal,
-                                                   WorstBound);
-        } else {
-            char buffer[20000];
-            // local variables of slave
-            std::deque<Subproblem_Params> LocalTaskQueue;
-            Domain_Type LocalBestBound = WorstBound;
+        // local variables of slave
+        std::deque<Subproblem_Params> LocalTaskQueue;
+        std::vector<Subproblem_Params> ReceivedPackage;
+        Domain_Type LocalBestBound = WorstBound;
 
-            int counter = 0;
+        int counter = 0;
 
-            while (true) {
-                MPI_Recv(buffer, 20000, MPI_CHAR, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
-                receivstream.str(buffer);
-                if (st.MPI_TAG == PtoP::MessageType::PROB) { // is 0 if equal
+        this->channel.Start(Master, PtoP::MessageType::GET_WORKERS, PtoP::MessageType::IDLE, this->comm);
+        MPI_Request &SlaveReq = this->channel.Pending();
+
+        // a racing ramp-up starts with the own share of the first subproblems instead of a package from the master
+        bool Racing = this->Ramp == RampUp_Type::RACING && Master == 0;
+        if (Racing)
+            LocalTaskQueue = ShareOf(ExpandBreadthFirst(Problem_Def, prob, goal, this->eps, this->RampUpNodes * (num - 1),
+                                                        *this->control, LocalBestBound, BestSubproblem), pid - 1, num - 1);
+        if (Racing) this->stats.RampUpShare = (long long) LocalTaskQueue.size();
+
+        while (true) {
+            if (Racing) {
+                st.MPI_TAG = PtoP::MessageType::PROB;
+            } else {
+                this->cancellation.Wait(st);
+                ReceiveMessage(receivbuffer, st.MPI_SOURCE, st.MPI_TAG, st, this->comm);
+            }
+            if (st.MPI_TAG == PtoP::MessageType::PROB) { // is 0 if equal
+                if (Racing) {
+                    Racing = false;
+                } else {
                     //slave has been given a partially solved problem to expand
-                    int NumOfProblems;
-                    receivstream >> NumOfProblems;
-                    for (int i = 0; i < NumOfProblems; i++) {
-                        Subproblem_Params Received_Params;
-                        encoder.Decode_Solution(receivstream, Received_Params);
-                        LocalTaskQueue.push_back(Received_Params);
-                    }
+                    encoder.Decode_Package(receivbuffer, ReceivedPackage);
+                    // the first package from the master is the share of the ramp-up
+                    if (this->Ramp == RampUp_Type::MASTER_BFS && Master == 0 && NumProblemsSolved == 0)
+                        this->stats.RampUpShare = (long long) ReceivedPackage.size();
+                    std::move(ReceivedPackage.begin(), ReceivedPackage.end(), std::back_inserter(LocalTaskQueue));
 
                     Domain_Type newBoundValue;
-                    receivstream >> newBoundValue;
+                    receivbuffer.Read(newBoundValue);
+                    this->pace.Resume(counter);
                     // for debugging it should not be the case that anyone sends a worse bound then what we already have
                     if (((bool) goal && newBoundValue >= LocalBestBound)
                         || (!(bool) goal && newBoundValue <= LocalBestBound)) {
                         LocalBestBound = newBoundValue;
                     }
+                }
+
+                while (!LocalTaskQueue.empty()) {
+                    // a cancelled search drops its open nodes, the worker then reports idle as usual
+                    if (counter % this->pace.Frequency() == 0 && this->cancellation.Check()) {
+                        LocalTaskQueue.clear();
+                        break;
+                    }
+                    NumProblemsSolved++;
+                    this->stats.Solved++;
+                    //take out one element from queue, expand it
+                    Subproblem_Params sol = GetNextSubproblem(LocalTaskQueue, this->mode);
+
+                    //ignore if its bound is worse than already known best sol.
+                    auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+                    if (((bool) goal && LowerBound < LocalBestBound)
+                        || (!(bool) goal && LowerBound > LocalBestBound)) {
+                        ProblemsEliminated++;
+                        continue;
+                    }
 
-                    while (!LocalTaskQueue.empty()) {
-                        NumProblemsSolved++;
-                        //take out one element from queue, expand it
-                        Subproblem_Params sol = GetNextSubproblem(LocalTaskQueue, this->mode);
-
-                        //ignore if its bound is worse than already known best sol.
-                        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
-                        if (((bool) goal && LowerBound < LocalBestBound)
-                            || (!(bool) goal && LowerBound > LocalBestBound)) {
-                            ProblemsEliminated++;
-                            continue;
+                    // try to make the bound better only if the solution lies in a feasible domain
+                    auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+                    Domain_Type CandidateBound;
+                    bool IsPotentialCandidate = false;
+                    if (Feasibility == BnB::FEASIBILITY::Full) {
+                        CandidateBound = (Problem_Def.GetContainedUpperBound(prob, sol));
+                        if (((bool) goal && CandidateBound >= LocalBestBound)
+                            || (!(bool) goal && CandidateBound <= LocalBestBound)) {
+                            IsPotentialCandidate = true;
+                            LocalBestBound = CandidateBound;
+                            this->control->Improved(CandidateBound, sol);
+                            this->ShareBound(LocalBestBound);
                         }
+                    } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
+                        // use our backup for the CandidateBound
+                        CandidateBound = UpperBound;
+                    } else if (Feasibility == BnB::FEASIBILITY::NONE) // basically discard again
+                        continue;
 
-                        // try to make the bound better only if the solution lies in a feasible domain
-                        auto Feasibility = Problem_Def.IsFeasible(prob, sol);
-                        Domain_Type CandidateBound;
-                        bool IsPotentialCandidate = false;
-                        if (Feasibility == BnB::FEASIBILITY::Full) {
-                            CandidateBound = (Problem_Def.GetContainedUpperBound(prob, sol));
-                            if (((bool) goal && CandidateBound >= LocalBestBound)
-                                || (!(bool) goal && CandidateBound <= LocalBestBound)) {
-                                IsPotentialCandidate = true;
-                                LocalBestBound = CandidateBound;
-                            }
-                        } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
-                            // use our backup for the CandidateBound
-                            CandidateBound = UpperBound;
-                        } else if (Feasibility == BnB::FEASIBILITY::NONE) // basically discard again
-                            continue;
-
-                        std::vector<Subproblem_Params> v;
-                        if (std::abs(CandidateBound - LowerBound) > this->eps) { // epsilon criterion for convergence
-                            v = Problem_Def.SplitSolution(prob, sol);
-                            for (auto &&el : v) {
-                                LocalTaskQueue.push_back(el);
-                            }
-                        } else if (IsPotentialCandidate) {
-                            BestSubproblem = sol;
+                    std::vector<Subproblem_Params> v;
+                    if (std::abs(CandidateBound - LowerBound) > this->eps) { // epsilon criterion for convergence
+                        v = Problem_Def.SplitSolution(prob, sol);
+                        for (auto &&el : v) {
+                            LocalTaskQueue.push_back(el);
                         }
+                    } else if (IsPotentialCandidate) {
+                        BestSubproblem = sol;
+                    }
 
-                        // request master for slaves
-                        if (counter % this->Communication_Frequency == 0 and !RequestOngoing) {
-                            sendstreams[0].str("");
-                            sendstreams[0] << LocalBestBound << " ";
-                            sendstreams[0] << (int) LocalTaskQueue.size() << " ";
-                            MPI_Isend(&sendstreams[0].str()[0], strlen(sendstreams[0].str().c_str()), MPI_CHAR, 0,
-                                      PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD, &SlaveReq);
+                    // request master for slaves
+                    if (counter % this->pace.Frequency() == 0) {
+                        this->pace.Communicated(counter);
+                        this->ShareBound(LocalBestBound);
+                        this->TestSends();
+                        if (!RequestOngoing) {
+                            this->channel.Request(LocalBestBound, (int) LocalTaskQueue.size());
+                            this->pace.Sent();
                             RequestOngoing = true;
                         }
+                    }
 
-                        if (RequestOngoing) {
-                            int flag = 0;
-                            MPI_Test(&SlaveReq, &flag, MPI_STATUS_IGNORE);
-                            if (flag == 1) {
-                                RequestOngoing = false;
-                                //get master's response
-                                MPI_Recv(buffer, 20000, MPI_CHAR, 0, PtoP::MessageType::GET_WORKERS, MPI_COMM_WORLD,
-                                         &st);
-                                receivstream.str(buffer);
-                                int slaves_avbl;
-                                Domain_Type MastersBound;
-                                receivstream >> MastersBound;
-
-                                if (((bool) goal && MastersBound >= LocalBestBound)
-                                    || (!(bool) goal && MastersBound <= LocalBestBound)) {
-                                    LocalBestBound = MastersBound;
-                                }
+                    if (RequestOngoing) {
+                        int flag = 0;
+                        MPI_Test(&SlaveReq, &flag, MPI_STATUS_IGNORE);
+                        if (flag == 1) {
+                            RequestOngoing = false;
+                            //get master's response
+                            ReceiveMessage(receivbuffer, Master, PtoP::MessageType::GET_WORKERS, st, this->comm);
+                            this->pace.Answered();
+                            int slaves_avbl;
+                            Domain_Type MastersBound;
+                            receivbuffer.Read(MastersBound);
 
-                                receivstream >> slaves_avbl;
-
-                                for (int i = 0; i < slaves_avbl; i++) {
-                                    //give a problem to each slave
-                                    int sl_no;
-                                    receivstream >> sl_no;
-                                    int RestSize = std::min(this->MaxPackageSize, (int) LocalTaskQueue.size());
-                                    std::vector<Subproblem_Params> SubproblemsToSend;
-                                    while (!LocalTaskQueue.empty() and SubproblemsToSend.size() != RestSize) {
-                                        Subproblem_Params subprb = LocalTaskQueue.front();
-                                        LocalTaskQueue.pop_front();
-                                        auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, subprb);
-                                        if (((bool) goal && Lower < LocalBestBound)
-                                            || (!(bool) goal && Lower > LocalBestBound)) {
-                                            continue;
-                                        }
-                                        SubproblemsToSend.push_back(subprb);
-                                    }
+                            if (((bool) goal && MastersBound >= LocalBestBound)
+                                || (!(bool) goal && MastersBound <= LocalBestBound)) {
+                                LocalBestBound = MastersBound;
+                            }
 
-                                    sendstreams[sl_no].str("");
-                                    sendstreams[sl_no] << static_cast<int>(SubproblemsToSend.size()) << " ";
-                                    for (auto &&subproblem : SubproblemsToSend)
-                                        encoder.Encode_Solution(sendstreams[sl_no], subproblem);
-                                    sendstreams[sl_no] << LocalBestBound << " ";
-                                    //send it to idle processor
-                                    if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
-                                    MPI_Isend(&sendstreams[sl_no].str()[0], strlen(sendstreams[sl_no].str().c_str()),
-                                              MPI_CHAR, sl_no,
-                                              PtoP::MessageType::PROB, MPI_COMM_WORLD, &req[sl_no]);
-                                    OpenRequests[sl_no] = true;
+                            receivbuffer.Read(slaves_avbl);
+
+                            for (int i = 0; i < slaves_avbl; i++) {
+                                //give a problem to each slave
+                                int sl_no;
+                                receivbuffer.Read(sl_no);
+                                int RestSize = std::min(this->PackageSizeFor(sl_no, (int) LocalTaskQueue.size()),
+                                                        (int) LocalTaskQueue.size());
+                                std::vector<Subproblem_Params> SubproblemsToSend;
+                                while (!LocalTaskQueue.empty() and SubproblemsToSend.size() != RestSize) {
+                                    Subproblem_Params subprb = LocalTaskQueue.front();
+                                    LocalTaskQueue.pop_front();
+                                    auto[Lower, Upper] = Problem_Def.GetEstimateForBounds(prob, subprb);
+                                    if (((bool) goal && Lower < LocalBestBound)
+                                        || (!(bool) goal && Lower > LocalBestBound)) {
+                                        continue;
+                                    }
+                                    SubproblemsToSend.push_back(subprb);
                                 }
+
+                                if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
+                                sendbuffers[sl_no].Clear();
+                                encoder.Encode_Package(sendbuffers[sl_no], SubproblemsToSend);
+                                sendbuffers[sl_no].Write(LocalBestBound);
+                                //send it to idle processor
+                                MPI_Isend(sendbuffers[sl_no].Data(), sendbuffers[sl_no].Size(),
+                                          MPI_CHAR, sl_no,
+                                          PtoP::MessageType::PROB, this->comm, &req[sl_no]);
+                                OpenRequests[sl_no] = true;
+                                if (!SubproblemsToSend.empty()) this->stats.PackagesSent++;
                             }
                         }
+                    }
 
 
-                        counter++;
-                    }
-                    //This slave has now become idle (its queue is empty). Inform master.
-                    sendstreams[0].str("");
-                    MPI_Ssend(&sendstreams[0].str()[0], 0, MPI_CHAR, 0, PtoP::MessageType::IDLE, MPI_COMM_WORLD);
-                } else if (st.MPI_TAG == PtoP::MessageType::FINISH) {
-                    printProc(
-                            "I have solved " << NumProblemsSolved << " problems and eliminated " << ProblemsEliminated);
-                    break; // empty solution only master will return a meaningful solution
-                } else if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) { // this is only a deadlock prevention measure
-                    RequestOngoing = false;
-                    //get master's response
-                    receivstream.str(buffer);
-                    int slaves_avbl;
-                    Domain_Type MastersBound;
-                    receivstream >> MastersBound;
-
-                    if (((bool) goal && MastersBound >= LocalBestBound)
-                        || (!(bool) goal && MastersBound <= LocalBestBound)) {
-                        LocalBestBound = MastersBound;
-                    }
+                    counter++;
+                }
+                //This slave has now become idle (its queue is empty). Inform master.
+                this->channel.Idle();
+            } else if (st.MPI_TAG == PtoP::MessageType::FINISH) {
+                printProc(
+                        "I have solved " << NumProblemsSolved << " problems and eliminated " << ProblemsEliminated);
+                break; // empty solution only master will return a meaningful solution
+            } else if (st.MPI_TAG == PtoP::MessageType::GET_WORKERS) { // this is only a deadlock prevention measure
+                // the master answered so it has the request, this completes at once
+                MPI_Wait(&SlaveReq, MPI_STATUS_IGNORE);
+                RequestOngoing = false;
+                this->pace.Answered();
+                //get master's response
+                int slaves_avbl;
+                Domain_Type MastersBound;
+                receivbuffer.Read(MastersBound);
 
-                    receivstream >> slaves_avbl;
-
-                    for (int i = 0; i < slaves_avbl; i++) {
-                        //give a problem to each slave
-                        int sl_no;
-                        receivstream >> sl_no;
-
-                        sendstreams[sl_no].str("");
-                        sendstreams[sl_no] << 0 << " ";
-                        //send it to idle processor
-                        sendstreams[sl_no] << LocalBestBound << " ";
-                        if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
-                        MPI_Isend(&sendstreams[sl_no].str()[0], strlen(sendstreams[sl_no].str().c_str()), MPI_CHAR,
-                                  sl_no,
-                                  PtoP::MessageType::PROB, MPI_COMM_WORLD, &req[sl_no]);
-                        OpenRequests[sl_no] = true;
-                    }
+                if (((bool) goal && MastersBound >= LocalBestBound)
+                    || (!(bool) goal && MastersBound <= LocalBestBound)) {
+                    LocalBestBound = MastersBound;
                 }
-            }
-        }
 
-        // cleanup
-        if (pid != 0) {
-            if (RequestOngoing)
-                MPI_Request_free(&SlaveReq);
-            for (int i = 1; i < num; i++)
-                if (OpenRequests[i]) MPI_Request_free(&req[i]);
-        }
+                receivbuffer.Read(slaves_avbl);
 
+                for (int i = 0; i < slaves_avbl; i++) {
+                    //give a problem to each slave
+                    int sl_no;
+                    receivbuffer.Read(sl_no);
 
-        // ------------------------ ALL procs have a best solution now master has to gather it
-        return ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(sendstreams[0], receivstream,
-                                                                                BestSubproblem,
-                                                                                Problem_Def,
-                                                                                prob,
-                                                                                encoder,
-                                                                                goal);
+                    if (OpenRequests[sl_no]) MPI_Wait(&req[sl_no], MPI_STATUS_IGNORE);
+                    sendbuffers[sl_no].Clear();
+                    encoder.Encode_Package(sendbuffers[sl_no], {});
+                    //send it to idle processor
+                    sendbuffers[sl_no].Write(LocalBestBound);
+                    MPI_Isend(sendbuffers[sl_no].Data(), sendbuffers[sl_no].Size(), MPI_CHAR,
+                              sl_no,
+                              PtoP::MessageType::PROB, this->comm, &req[sl_no]);
+                    OpenRequests[sl_no] = true;
+                }
+            }
+        }
+
+        // cleanup, the master only finishes once every message was received so all sends are complete.
+        // Waiting instead of freeing keeps the buffers safe for the next search
+        this->channel.Finish();
+        for (int i = 0; i < num; i++)
+            if (OpenRequests[i]) MPI_Wait(&req[i], MPI_STATUS_IGNORE);
+        return BestSubproblem;
     }
 }
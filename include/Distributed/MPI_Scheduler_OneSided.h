@@ -0,0 +1,205 @@
+#pragma once
+
+#include "MPI_Scheduler.h"
+#include "MPI_Task_Ring.h"
+#include <random>
+#include <chrono>
+#include <thread>
+
+namespace BnB {
+    // work stealing where the victim never has to answer. Every process works on a private queue and keeps a
+    // few of its oldest subproblems in its MPI_Task_Ring, idle processes take from their own ring first and
+    // then from the ring of a random victim. Bounds are shared through the incumbent window (on by default).
+    //
+    // Termination uses the counter of open subproblems on process 0. A process only reports the change of
+    // its open subproblems lazily when the change is negative, a positive change is reported at once together
+    // with a reserve. So the counter is never smaller than the real number and reaches 0 exactly when the
+    // search is done
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    class MPI_Scheduler_OneSided : public MPI_Scheduler<Prob_Consts, Subproblem_Params, Domain_Type> {
+    public:
+        MPI_Scheduler_OneSided() { this->UseIncumbentWindow = true; }
+
+        Subproblem_Params Execute(const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                                  const Prob_Consts &prob,
+                                  const MPI_Message_Encoder <Subproblem_Params> &encoder,
+                                  const Goal goal,
+                                  const Domain_Type WorstBound) override;
+
+        // number of slots of the ring a process exposes to thieves, it keeps the ring at most half full
+        MPI_Scheduler_OneSided<Prob_Consts, Subproblem_Params, Domain_Type> *RingSlots(int num) { Slots = num; return this; }
+        // bytes of a slot of the ring, a bigger subproblem takes several slots. A subproblem bigger than the whole
+        // ring cannot be stolen and stays with the process that made it
+        MPI_Scheduler_OneSided<Prob_Consts, Subproblem_Params, Domain_Type> *SlotSize(int bytes) { SlotBytes = bytes; return this; }
+
+    private:
+        int Slots = 64;
+        int SlotBytes = 1024;
+        // open subproblems reported ahead of time so that not every split has to update the counter
+        const long long WorkReserve = 256;
+        // an idle process that found nothing to take in IdleSpins rounds sleeps, starting at 1 microsecond and
+        // doubling up to MaxIdleSleepMicroseconds, so that it does not flood process 0 and the victims with atomics
+        const int IdleSpins = 8;
+        const int MaxIdleSleepMicroseconds = 256;
+
+        MPI_Task_Ring<Subproblem_Params> ring;
+    };
+
+
+    template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params MPI_Scheduler_OneSided<Prob_Consts, Subproblem_Params, Domain_Type>::Execute(
+            const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Prob_Consts &prob,
+            const MPI_Message_Encoder <Subproblem_Params> &encoder,
+            const Goal goal,
+            const Domain_Type WorstBound) {
+        int pid, num;
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
+        this->PrepareBuffers(num);
+        this->StartSearch(Problem_Def, prob, goal, WorstBound);
+        ring.Start(Slots, SlotBytes, 1, this->comm);
+
+        std::deque<Subproblem_Params> LocalTaskQueue;
+        std::vector<Subproblem_Params> Taken;
+        Domain_Type LocalBestBound = WorstBound;
+        Subproblem_Params BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
+        if (pid == 0)
+            LocalTaskQueue.push_back(BestSubproblem);
+
+        // subproblems created minus subproblems finished here that the counter does not know about, never positive
+        long long Unreported = 0;
+        std::mt19937 random(pid);
+        int counter = 0;
+        int NumProblemsSolved = 0;
+        int NumSteals = 0;
+        int FailedSteals = 0;
+        int IdleRounds = 0;
+        int IdleSleep = 0;
+
+        while (true) {
+            if (!LocalTaskQueue.empty()) {
+                // a cancelled search drops its open nodes, they count as finished
+                if (this->control->IsCancelled()
+                    || (counter % this->pace.Frequency() == 0 && this->cancellation.Check())) {
+                    Unreported -= LocalTaskQueue.size();
+                    LocalTaskQueue.clear();
+                    continue;
+                }
+
+                // the oldest subproblems are the biggest ones, they are the ones worth stealing
+                if (counter % this->pace.Frequency() == 0) {
+                    this->pace.Communicated(counter);
+                    this->ShareBound(LocalBestBound);
+                    // subproblems too big for the ring stay here and the ones behind them are tried
+                    auto it = LocalTaskQueue.begin();
+                    for (int Tries = Slots / 2; Tries > 0 && LocalTaskQueue.size() > 1 && it != LocalTaskQueue.end()
+                                                && ring.Published() < Slots / 2; Tries--) {
+                        Publication Result = ring.Publish(*it, encoder);
+                        if (Result == Publication::FULL) break;
+                        if (Result == Publication::TOO_BIG) {
+                            this->stats.KeptTooBig++;
+                            ++it;
+                            continue;
+                        }
+                        it = LocalTaskQueue.erase(it);
+                    }
+                }
+                counter++;
+                NumProblemsSolved++;
+                Unreported--;
+
+                Subproblem_Params sol = GetNextSubproblem(LocalTaskQueue, this->mode);
+
+                //ignore if its bound is worse than already known best sol.
+                auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+                if (((bool) goal && LowerBound < LocalBestBound)
+                    || (!(bool) goal && LowerBound > LocalBestBound)) {
+                    continue;
+                }
+
+                // try to make the bound better only if the solution lies in a feasible domain
+                auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+                Domain_Type CandidateBound = UpperBound;
+                if (Feasibility == BnB::FEASIBILITY::Full) {
+                    CandidateBound = (Problem_Def.GetContainedUpperBound(prob, sol));
+                    if (((bool) goal && CandidateBound >= LocalBestBound)
+                        || (!(bool) goal && CandidateBound <= LocalBestBound)) {
+                        LocalBestBound = CandidateBound;
+                        BestSubproblem = sol;
+                        this->control->Improved(CandidateBound, sol);
+                        this->ShareBound(LocalBestBound);
+                    }
+                } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
+                    // use our backup for the CandidateBound
+                    CandidateBound = UpperBound;
+                } else if (Feasibility == BnB::FEASIBILITY::NONE) // basically discard again
+                    continue;
+
+                if (std::abs(CandidateBound - LowerBound) > this->eps) { // epsilon criterion for convergence
+                    std::vector<Subproblem_Params> v = Problem_Def.SplitSolution(prob, sol);
+                    Unreported += v.size();
+                    for (auto &&el : v)
+                        LocalTaskQueue.push_back(el);
+                }
+                if (Unreported > 0) {
+                    ring.AddWork(Unreported + WorkReserve);
+                    Unreported = -WorkReserve;
+                }
+                continue;
+            }
+
+            // idle, the own ring first then a random victim
+            Taken.clear();
+            if (ring.Take(pid, Taken, encoder) == 0 && num > 1) {
+                int victim = std::uniform_int_distribution<int>(0, num - 2)(random);
+                if (victim >= pid) victim++;
+                if (ring.Take(victim, Taken, encoder) > 0) NumSteals++;
+                else FailedSteals++;
+            }
+            if (!Taken.empty()) {
+                IdleRounds = 0;
+                IdleSleep = 0;
+                this->pace.Resume(counter);
+                std::move(Taken.begin(), Taken.end(), std::back_inserter(LocalTaskQueue));
+                continue;
+            }
+
+            // nothing to take, the search is over once the counter says no subproblem is left anywhere
+            if (Unreported != 0) {
+                ring.AddWork(Unreported);
+                Unreported = 0;
+            }
+            this->cancellation.Check();
+            this->ShareBound(LocalBestBound);
+            if (ring.OpenWork() == 0) break;
+            if (++IdleRounds > IdleSpins) {
+                IdleSleep = std::min(std::max(2 * IdleSleep, 1), MaxIdleSleepMicroseconds);
+                std::this_thread::sleep_for(std::chrono::microseconds(IdleSleep));
+            }
+        }
+
+        printProc("I have solved " << NumProblemsSolved << " problems, stole " << NumSteals << " times and failed "
+                                   << FailedSteals << " times");
+        this->stats.Solved = NumProblemsSolved;
+        this->stats.Steals = NumSteals;
+        this->stats.FailedSteals = FailedSteals;
+
+        ring.Finish();
+        this->FinishSearch();
+
+        // ------------------------ ALL procs have a best solution now master has to gather it
+        BestSubproblem = ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(this->sendbuffers[0],
+                                                                                          this->receivbuffer,
+                                                                                          BestSubproblem,
+                                                                                          Problem_Def,
+                                                                                          prob,
+                                                                                          encoder,
+                                                                                          goal,
+                                                                                          this->comm,
+                                                                                          this->BroadcastSolution);
+        if (pid == 0)
+            this->control->Improved(Problem_Def.GetContainedUpperBound(prob, BestSubproblem), BestSubproblem);
+        return BestSubproblem;
+    }
+}
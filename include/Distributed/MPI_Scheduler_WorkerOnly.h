@@ -1,12 +1,18 @@
 #pragma once
 
 #include "MPI_Scheduler.h"
+#include "MPI_Task_Ring.h"
+#include "MPI_Checkpoint.h"
+#include <random>
 
 namespace BnB {
     namespace Collective {
         enum MessageType {
             IDLE_PROC_WANTS_WORK = 0,
             WORK_EXCHANGE = 1,
+            TOKEN = 2,      // termination detection token that travels along the ring of processes
+            TERMINATE = 3,  // the search is over, first round along the ring
+            FINAL = 4,      // second round along the ring, after it nobody sends new requests
         };
     }
 
@@ -19,20 +25,59 @@ namespace BnB {
                                   const Goal goal,
                                   const Domain_Type WorstBound) override;
 
+        // number of idle iterations process 0 waits before it starts a new termination round
         MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *TermCheckFrequency(int freq) { TerminationCheckFrequency = freq; return this;}
+        // failed steals on the own node before an idle process asks another node, doubles after every failed
+        // steal from another node (up to MaxNodeLocalSteals) so that idle processes do not flood the network
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *NodeLocalSteals(int num) { LocalStealsBeforeRemote = num; return this;}
+        // the processes of a node share work through task rings in shared memory instead of messages
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *NodePool(bool use) { UseNodePool = use; return this;}
+        // slots of the ring a process offers to its node, it keeps the ring at most half full
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *PoolSlots(int num) { NumPoolSlots = num; return this;}
+        // bytes of a slot of the ring, a bigger subproblem takes several slots
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *PoolSlotSize(int bytes) { PoolSlotBytes = bytes; return this;}
+        // a cancelled search keeps its open subproblems and writes them to a checkpoint at Path instead of dropping
+        // them, an empty path turns it off. Cancelling and restarting is also the way to checkpoint periodically
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *Checkpoint(const std::string &Path) { CheckpointPath = Path; return this;}
+        // the next search starts from the checkpoint at Path instead of the root, spread over all processes
+        MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type> *Restart(const std::string &Path) { RestartPath = Path; return this;}
 
     private:
         int TerminationCheckFrequency = 100;
+        int LocalStealsBeforeRemote = 2;
+        const int MaxNodeLocalSteals = 64;
+        bool UseNodePool = true;
+        int NumPoolSlots = 64;
+        int PoolSlotBytes = 1024;
+        MPI_Task_Ring<Subproblem_Params> pool;
+        // the processes on the own node and on other nodes, found once per communicator
+        std::vector<int> SameNode, OtherNodes;
+        MPI_Comm NodesOf = MPI_COMM_NULL;
         float PercentageToShare = 0.5f;
+        std::string CheckpointPath;
+        std::string RestartPath;
+        MPI_Checkpoint<Subproblem_Params, Domain_Type> checkpoint;
     };
 
 
-    template<typename T> MPI_Datatype ConvertTypeToMPIType() { assert(false); }
-    template<> MPI_Datatype ConvertTypeToMPIType<int>() { return MPI_INT; }
-    template<> MPI_Datatype ConvertTypeToMPIType<float>() { return MPI_FLOAT; }
-    template<> MPI_Datatype ConvertTypeToMPIType<double>() { return MPI_DOUBLE; }
-
-
+/* Work sharing:
+ *  idle processes take work from the task rings of their node (their own first), the busy processes keep
+ *  some of their oldest subproblems there. Only after failed takes they send a steal request to a process on
+ *  another node, without the node pool to a process on their own node first.
+ *
+ * Termination detection after Dijkstra and Safra:
+ *  every process counts the work packages it sent minus the ones it received and turns black when it
+ *  receives one. A token travels along the ring 0 -> 1 -> ... -> num-1 -> 0, an idle process adds its count
+ *  to the token, colours it black if it is black itself and becomes white. If the token comes back white
+ *  to a white and idle process 0 and the counts add up to 0, no process has work and no work is in flight.
+ *  Each check costs one small message per process no matter how many processes there are.
+ *
+ *  A subproblem put in a task ring counts as a package sent until somebody takes it.
+ *  Steal requests and empty answers can not give anybody work so they are not counted. They can still be
+ *  in flight when the search ends, as can be one bound exchange. So the end is announced in two rounds:
+ *  after TERMINATE a process sends no new requests and starts no new bound exchange, after FINAL every
+ *  process catches up with the bound exchanges and answers requests until all processes are in a barrier.
+ */
     template<typename Prob_Consts, typename Subproblem_Params, typename Domain_Type>
     Subproblem_Params MPI_Scheduler_WorkerOnly<Prob_Consts, Subproblem_Params, Domain_Type>::Execute(
             const Problem_Definition <Prob_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
@@ -42,56 +87,93 @@ namespace BnB {
             const Domain_Type WorstBound) {
 
         int pid, num;
-        MPI_Comm_rank(MPI_COMM_WORLD, &pid);
-        MPI_Comm_size(MPI_COMM_WORLD, &num);
+        MPI_Comm_rank(this->comm, &pid);
+        MPI_Comm_size(this->comm, &num);
         assert(num >= 2 && "this implementation needs at least 2 cores");
         MPI_Status st;
         MPI_Status throwAway;
-        MPI_Request workReq, terminationReq, boundexchangeReq;
-        std::vector<MPI_Request> ShareRequests(num);
-        std::vector<bool> ShareRequest_ongoing(num, false);
-
-        std::vector<std::stringstream> sendstreams(num);
-        for (auto &stream : sendstreams)
-            stream << std::setprecision(15);
-        std::stringstream receivstream("");
-        receivstream << std::setprecision(15);
+        MPI_Request workReq = MPI_REQUEST_NULL, boundexchangeReq = MPI_REQUEST_NULL;
+        this->PrepareBuffers(num);
+        auto &ShareRequests = this->req;
+        auto &ShareRequest_ongoing = this->OpenRequests;
+        auto &sendbuffers = this->sendbuffers;
+        auto &receivbuffer = this->receivbuffer;
+        this->StartSearch(Problem_Def, prob, goal, WorstBound);
+
+        // the bound exchange reduces to the best bound of all processes, so its cost does not grow with num
+        MPI_Op BestOf = (bool) goal ? MPI_MAX : MPI_MIN;
+        Domain_Type GlobalBestBound;
 
-        auto *BestBoundArray  = new Domain_Type[num];
-        auto *IdleStatusArray = new int[num];
-
-        int BoundToTerminationCheckRatio = this->TerminationCheckFrequency / this->Communication_Frequency;
-		std::cout << "TermFreq: " << this->TerminationCheckFrequency << " CommFreq: " << this->Communication_Frequency << std::endl;
-        assert(BoundToTerminationCheckRatio > 1 && "in order for the algorithm to work the bound exchange needs to be done more frequently than termination.");
-
-        char buffer[20000];
         int NumMessages = 0;
-        int NumProblemsSolved = 0;
+        long long NumProblemsSolved = 0;
 
         std::deque<Subproblem_Params> LocalTaskQueue;
+        std::vector<Subproblem_Params> ReceivedPackage;
         Domain_Type LocalBestBound = WorstBound;
         Domain_Type LocalBoundToShare;
         Subproblem_Params BestSubproblem;
-        int ImIdle;
-        int ProcWhomISend;
+        int ProcWhomISend = -1; // victim of the open steal request
         bool RequestSent = false;
-        bool IallgatherOngoing = false;
-        bool BoundComm = true;
-        bool IsTerminationAllgatherGoingOn = false;
+        bool IallreduceOngoing = false;
+        long long BoundExchanges = 0;
+
+        // steal victims, a process on the own node is asked first as that answer does not cross the network
+        if (NodesOf != this->comm) {
+            SplitByNode(SameNode, OtherNodes, this->comm);
+            NodesOf = this->comm;
+        }
+        std::mt19937 random(pid);
+        if (UseNodePool) pool.StartNode(NumPoolSlots, PoolSlotBytes, this->comm);
+        const bool Pooling = UseNodePool && pool.Size() > 1;
+        // a process of the node holds subproblems that are too big for the pool
+        bool PoolOverflow = false;
+        std::vector<Subproblem_Params> Taken;
+        bool VictimIsRemote = false;
+        int FailedLocalSteals = 0;
+        int LocalStealsAllowed = LocalStealsBeforeRemote;
+        int LocalSteals = 0, RemoteSteals = 0, FailedRemoteSteals = 0;
+
+        // termination detection
+        const int NextProc = (pid + 1) % num;
+        const int PrevProc = (pid + num - 1) % num;
+        long long PackagesSent = 0; // work packages sent minus work packages received
+        bool Black = false;
+        bool HaveToken = pid == 0;
+        bool RoundStarted = false;  // only used by process 0
+        long long Token[2] = {0, 0}; // count and colour
+        int IdleIterations = 0;
+        bool Terminating = false;
+        long long MaxBoundExchanges = 0;
 
         BestSubproblem = Problem_Def.GetInitialSubproblem(prob);
 
-        if (pid == 0) {
+        if (!RestartPath.empty()) {
+            checkpoint.Read(RestartPath, this->comm, encoder, goal, LocalTaskQueue, LocalBestBound, BestSubproblem,
+                            NumProblemsSolved);
+            RestartPath.clear();
+            if (LocalBestBound != WorstBound) {
+                this->control->BoundImproved(LocalBestBound);
+                this->ShareBound(LocalBestBound);
+            }
+        } else if (pid == 0) {
             LocalTaskQueue.push_back(BestSubproblem);
         }
 
-        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Barrier(this->comm);
 
         int counter = 0;
-        int counter2 = 0;
         int IdleProcAsksForWork = 0;
         while (true) {
-            if (!LocalTaskQueue.empty()) {
+            // a cancelled search drops its open nodes, the termination detection then finds every process idle.
+            // With a checkpoint it keeps them and counts as idle, it no longer expands, shares or steals and only
+            // takes back what it offered to its node. Other processes are asked with the rest of the communication
+            bool Cancelled = (counter % this->pace.Frequency() == 0 && this->cancellation.Check())
+                             || this->control->IsCancelled();
+            bool Suspended = Cancelled && !CheckpointPath.empty();
+            if (Cancelled && !Suspended)
+                LocalTaskQueue.clear();
+
+            if (!LocalTaskQueue.empty() && !Suspended) {
                 NumProblemsSolved++;
 
                 //take out one element from queue, expand it
@@ -113,6 +195,8 @@ namespace BnB {
                         || (!(bool) goal && CandidateBound <= LocalBestBound)) {
                         LocalBestBound = CandidateBound;
                         BestSubproblem = sol;
+                        this->control->Improved(CandidateBound, sol);
+                        this->ShareBound(LocalBestBound);
                     }
                 } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
                     // use our backup for the CandidateBound
@@ -129,15 +213,17 @@ namespace BnB {
             }
             // communication phase -----------------------------------------------------------------------------------------
             // test if someone needs work
-            MPI_Iprobe(MPI_ANY_SOURCE, Collective::MessageType::IDLE_PROC_WANTS_WORK, MPI_COMM_WORLD,
+            MPI_Iprobe(MPI_ANY_SOURCE, Collective::MessageType::IDLE_PROC_WANTS_WORK, this->comm,
                        &IdleProcAsksForWork, &st); // test if another processor has sent me a request
             if (IdleProcAsksForWork == 1) {
                 NumMessages++;
                 int target = st.MPI_SOURCE;
-                MPI_Recv(buffer, 1, MPI_CHAR, target, Collective::MessageType::IDLE_PROC_WANTS_WORK,
-                         MPI_COMM_WORLD, &st);
+                char anything;
+                MPI_Recv(&anything, 1, MPI_CHAR, target, Collective::MessageType::IDLE_PROC_WANTS_WORK,
+                         this->comm, &st);
                 int queueSize = LocalTaskQueue.size();
-                int shareSize = std::min(static_cast<int>(queueSize * this->PercentageToShare), this->MaxPackageSize);
+                int shareSize = Suspended ? 0 : std::min(static_cast<int>(queueSize * this->PercentageToShare),
+                                                         this->pace.PackageSize(queueSize));
                 // get shareSize many problems that are not trivial
                 std::vector<Subproblem_Params> SubproblemsToSend;
                 while (!LocalTaskQueue.empty() and SubproblemsToSend.size() != shareSize) {
@@ -150,52 +236,119 @@ namespace BnB {
                     }
                     SubproblemsToSend.push_back(subprb);
                 }
+                if (!SubproblemsToSend.empty()) PackagesSent++;
 
-                sendstreams[target].str("");
-                sendstreams[target] << LocalBestBound << " ";
-                sendstreams[target] << static_cast<int>(SubproblemsToSend.size()) << " ";
-                for (auto &&subproblem : SubproblemsToSend)
-                    encoder.Encode_Solution(sendstreams[target], subproblem);
-                assert(strlen(sendstreams[target].str().c_str()) < 20000 &&
-                       "buffer full!, make MaxPackageSize smaller");
                 if (ShareRequest_ongoing[target]) MPI_Wait(&ShareRequests[target], MPI_STATUS_IGNORE);
-                MPI_Issend(sendstreams[target].str().c_str(), strlen(sendstreams[target].str().c_str()), MPI_CHAR,
+                sendbuffers[target].Clear();
+                sendbuffers[target].Write(LocalBestBound);
+                encoder.Encode_Package(sendbuffers[target], SubproblemsToSend);
+                MPI_Issend(sendbuffers[target].Data(), sendbuffers[target].Size(), MPI_CHAR,
                            target,
-                           Collective::MessageType::WORK_EXCHANGE, MPI_COMM_WORLD, &ShareRequests[target]);
+                           Collective::MessageType::WORK_EXCHANGE, this->comm, &ShareRequests[target]);
                 ShareRequest_ongoing[target] = true;
                 IdleProcAsksForWork = 0;
             }
 
 
-            // send work request when idle
-            if (LocalTaskQueue.empty()) {
-                if (!RequestSent) {
+            // offer the oldest subproblems to the node, they are the biggest ones
+            // subproblems too big for the ring stay here and the ones behind them are tried, the node is told so
+            // that its idle processes also ask by message
+            if (Pooling && !Suspended && counter % this->pace.Frequency() == 0) {
+                auto it = LocalTaskQueue.begin();
+                for (int Tries = NumPoolSlots / 2; Tries > 0 && LocalTaskQueue.size() > 1 && it != LocalTaskQueue.end()
+                                                && pool.Published() < NumPoolSlots / 2; Tries--) {
+                    Publication Result = pool.Publish(*it, encoder);
+                    if (Result == Publication::FULL) break;
+                    if (Result == Publication::TOO_BIG) {
+                        this->stats.KeptTooBig++;
+                        if (!PoolOverflow) pool.Overflow();
+                        PoolOverflow = true;
+                        ++it;
+                        continue;
+                    }
+                    it = LocalTaskQueue.erase(it);
+                    PackagesSent++;
+                }
+            }
+
+            // take from the node without a message when idle, the own ring first
+            if (Suspended && Pooling) {
+                Taken.clear();
+                PackagesSent -= pool.Take(pool.Rank(), Taken, encoder);
+                std::move(Taken.begin(), Taken.end(), std::back_inserter(LocalTaskQueue));
+            } else if (LocalTaskQueue.empty() && Pooling) {
+                Taken.clear();
+                int victim = pool.Rank();
+                int count = pool.Take(victim, Taken, encoder);
+                if (count == 0) {
+                    victim = std::uniform_int_distribution<int>(0, pool.Size() - 2)(random);
+                    if (victim >= pool.Rank()) victim++;
+                    count = pool.Take(victim, Taken, encoder);
+                }
+                if (count > 0) {
+                    PackagesSent -= count;
+                    this->stats.PoolTakes += count;
+                    if (victim != pool.Rank()) {
+                        Black = true;
+                        LocalSteals++;
+                        FailedLocalSteals = 0;
+                        LocalStealsAllowed = LocalStealsBeforeRemote;
+                    }
+                    std::move(Taken.begin(), Taken.end(), std::back_inserter(LocalTaskQueue));
+                } else {
+                    FailedLocalSteals++;
+                    this->stats.FailedSteals++;
+                    if (!PoolOverflow) PoolOverflow = pool.Overflowing();
+                }
+            }
+
+            // send work request when idle, a suspended process only waits for the answer to its last one
+            if (LocalTaskQueue.empty() || (Suspended && RequestSent)) {
+                // with the pool the own node is only asked by message for subproblems that did not fit into it
+                bool AskOtherNode = !OtherNodes.empty()
+                                    && (SameNode.empty() || FailedLocalSteals >= LocalStealsAllowed);
+                bool AskOwnNode = (!Pooling || PoolOverflow) && !SameNode.empty() && !AskOtherNode;
+                if (!RequestSent && !Terminating && !Suspended && (AskOtherNode || AskOwnNode)) {
                     char anything;
-                    ProcWhomISend = (rand() % static_cast<int>( num ));
-                    if (ProcWhomISend == pid) ProcWhomISend = (ProcWhomISend + 1) % num;
+                    VictimIsRemote = AskOtherNode;
+                    auto &Victims = VictimIsRemote ? OtherNodes : SameNode;
+                    ProcWhomISend = Victims[std::uniform_int_distribution<int>(0, Victims.size() - 1)(random)];
                     MPI_Issend(&anything, 1, MPI_CHAR, ProcWhomISend, Collective::MessageType::IDLE_PROC_WANTS_WORK,
-                               MPI_COMM_WORLD, &workReq);
+                               this->comm, &workReq);
+                    this->pace.Sent();
                     RequestSent = true;
-                } else {
+                } else if (RequestSent) {
                     int requestReceived = 0;
                     MPI_Test(&workReq, &requestReceived, MPI_STATUS_IGNORE);
                     if (requestReceived == 1) {
-                        MPI_Recv(buffer, 100000, MPI_CHAR, ProcWhomISend, Collective::MessageType::WORK_EXCHANGE,
-                                 MPI_COMM_WORLD, &throwAway);
-                        receivstream.str(buffer);
+                        assert(ProcWhomISend >= 0 && "an open steal request has a victim");
+                        ReceiveMessage(receivbuffer, ProcWhomISend, Collective::MessageType::WORK_EXCHANGE, throwAway,
+                                       this->comm);
+                        this->pace.Answered();
                         Domain_Type CandidateBound;
-                        receivstream >> CandidateBound;
+                        receivbuffer.Read(CandidateBound);
                         if (((bool) goal && CandidateBound > LocalBestBound)
                             || (!(bool) goal && CandidateBound < LocalBestBound)) {
                             LocalBestBound = CandidateBound;
                         }
-                        int numProblems;
-                        receivstream >> numProblems;
-                        for (int i = 0; i < numProblems; i++) {
-                            Subproblem_Params subprb;
-                            encoder.Decode_Solution(receivstream, subprb);
-                            LocalTaskQueue.push_back(subprb);
+                        encoder.Decode_Package(receivbuffer, ReceivedPackage);
+                        if (!ReceivedPackage.empty()) {
+                            PackagesSent--;
+                            Black = true;
+                            (VictimIsRemote ? RemoteSteals : LocalSteals)++;
+                            FailedLocalSteals = 0;
+                            LocalStealsAllowed = LocalStealsBeforeRemote;
+                        } else if (VictimIsRemote) {
+                            // back off, the next remote steal only comes after twice as many local ones
+                            FailedRemoteSteals++;
+                            this->stats.FailedSteals++;
+                            FailedLocalSteals = 0;
+                            LocalStealsAllowed = std::min(2 * LocalStealsAllowed, MaxNodeLocalSteals);
+                        } else {
+                            FailedLocalSteals++;
+                            this->stats.FailedSteals++;
                         }
+                        std::move(ReceivedPackage.begin(), ReceivedPackage.end(), std::back_inserter(LocalTaskQueue));
 
                         RequestSent = false;
                     }
@@ -203,100 +356,182 @@ namespace BnB {
             }
 
 
-            // the next following blocks alternate between communicating bounds and termination checks
+            // bound exchange -------------------------------------------------------------------------------------------
+            // the counter counts loop iterations, so the pace measures the time of one iteration
             counter++;
-            if (BoundComm) {
-                if ((counter % this->Communication_Frequency == 0) && !IallgatherOngoing) {
-                    LocalBoundToShare = LocalBestBound;
-                    MPI_Iallgather(&LocalBoundToShare, 1, MPI_DOUBLE,
-                                   BestBoundArray, 1, MPI_DOUBLE, MPI_COMM_WORLD,
-                                   &boundexchangeReq); // make it a vector
-                    IallgatherOngoing = true;
-                } else if (IallgatherOngoing) {
-                    int flag = 0;
-                    MPI_Test(&boundexchangeReq, &flag, MPI_STATUS_IGNORE);
+            bool Due = counter % this->pace.Frequency() == 0;
+            if (Due) {
+                this->pace.Communicated(counter);
+                this->ShareBound(LocalBestBound);
+            }
+            if (Due && !IallreduceOngoing && !Terminating) {
+                LocalBoundToShare = LocalBestBound;
+                MPI_Iallreduce(&LocalBoundToShare, &GlobalBestBound, 1, ConvertTypeToMPIType<Domain_Type>(), BestOf,
+                               this->comm, &boundexchangeReq);
+                IallreduceOngoing = true;
+                BoundExchanges++;
+            } else if (IallreduceOngoing) {
+                int flag = 0;
+                MPI_Test(&boundexchangeReq, &flag, MPI_STATUS_IGNORE);
+                if (flag == 1) {
+                    if (((bool) goal && GlobalBestBound > LocalBestBound)
+                        || (!(bool) goal && GlobalBestBound < LocalBestBound)) {
+                        LocalBestBound = GlobalBestBound;
+                    }
+                    IallreduceOngoing = false;
+                }
+            }
+
+            // termination detection ------------------------------------------------------------------------------------
+            bool Idle = LocalTaskQueue.empty() || Suspended;
+            IdleIterations = Idle ? IdleIterations + 1 : 0;
+            int flag = 0;
+            if (!Terminating) {
+                if (!HaveToken) {
+                    MPI_Iprobe(PrevProc, Collective::MessageType::TOKEN, this->comm, &flag, &st);
                     if (flag == 1) {
-                        for (int i = 0; i < num; i++) {
-                            if (((bool) goal && BestBoundArray[i] > LocalBestBound)
-                                || (!(bool) goal && BestBoundArray[i] < LocalBestBound)) {
-                                LocalBestBound = BestBoundArray[i];
-                            }
-                        }
-                        IallgatherOngoing = false;
-                        counter = 0;
-                        counter2++;
-                        if (counter2 % BoundToTerminationCheckRatio == 0) {
-                            BoundComm = false;
-                            counter2 = 0;
-                        }
+                        MPI_Recv(Token, 2, MPI_LONG_LONG, PrevProc, Collective::MessageType::TOKEN, this->comm,
+                                 MPI_STATUS_IGNORE);
+                        HaveToken = true;
                     }
                 }
-            } else {
-                if ((counter % this->Communication_Frequency == 0) && !IsTerminationAllgatherGoingOn) {
-                    ImIdle = static_cast<int>(LocalTaskQueue.empty());
-                    MPI_Iallgather(&ImIdle, 1, MPI_INT,
-                                   IdleStatusArray, 1, MPI_INT, MPI_COMM_WORLD, &terminationReq); // make it a vector
-                    IsTerminationAllgatherGoingOn = true;
-                } else if (IsTerminationAllgatherGoingOn) {
-                    int flag = 0;
-                    MPI_Test(&terminationReq, &flag, MPI_STATUS_IGNORE);
+                if (HaveToken && Idle) {
+                    if (pid != 0) {
+                        Token[0] += PackagesSent;
+                        Token[1] |= Black;
+                        MPI_Send(Token, 2, MPI_LONG_LONG, NextProc, Collective::MessageType::TOKEN, this->comm);
+                        Black = false;
+                        HaveToken = false;
+                    } else if (RoundStarted && !Token[1] && !Black && Token[0] + PackagesSent == 0) {
+                        Terminating = true;
+                        MaxBoundExchanges = BoundExchanges;
+                        MPI_Send(&MaxBoundExchanges, 1, MPI_LONG_LONG, NextProc, Collective::MessageType::TERMINATE,
+                                 this->comm);
+                    } else if (IdleIterations >= this->TerminationCheckFrequency) {
+                        // new round, the last one failed or none was started yet
+                        Token[0] = 0;
+                        Token[1] = 0;
+                        Black = false;
+                        MPI_Send(Token, 2, MPI_LONG_LONG, NextProc, Collective::MessageType::TOKEN, this->comm);
+                        RoundStarted = true;
+                        HaveToken = false;
+                        IdleIterations = 0;
+                    }
+                }
+                if (pid != 0) {
+                    MPI_Iprobe(PrevProc, Collective::MessageType::TERMINATE, this->comm, &flag, &st);
                     if (flag == 1) {
-                        int NumIdleProcs = 0;
-                        for (int i = 0; i < num; i++) {
-                            if (IdleStatusArray[i] == 1)
-                                NumIdleProcs++;
-                        }
-                        if (NumIdleProcs == num) break;
-                        IsTerminationAllgatherGoingOn = false;
-                        counter = 0;
-                        BoundComm = true;
+                        MPI_Recv(&MaxBoundExchanges, 1, MPI_LONG_LONG, PrevProc, Collective::MessageType::TERMINATE,
+                                 this->comm, MPI_STATUS_IGNORE);
+                        Terminating = true;
+                        MaxBoundExchanges = std::max(MaxBoundExchanges, BoundExchanges);
+                        MPI_Send(&MaxBoundExchanges, 1, MPI_LONG_LONG, NextProc, Collective::MessageType::TERMINATE,
+                                 this->comm);
                     }
                 }
+            } else if (pid == 0) {
+                MPI_Iprobe(PrevProc, Collective::MessageType::TERMINATE, this->comm, &flag, &st);
+                if (flag == 1) {
+                    MPI_Recv(&MaxBoundExchanges, 1, MPI_LONG_LONG, PrevProc, Collective::MessageType::TERMINATE,
+                             this->comm, MPI_STATUS_IGNORE);
+                    MPI_Send(&MaxBoundExchanges, 1, MPI_LONG_LONG, NextProc, Collective::MessageType::FINAL,
+                             this->comm);
+                    break;
+                }
+            } else {
+                MPI_Iprobe(PrevProc, Collective::MessageType::FINAL, this->comm, &flag, &st);
+                if (flag == 1) {
+                    MPI_Recv(&MaxBoundExchanges, 1, MPI_LONG_LONG, PrevProc, Collective::MessageType::FINAL,
+                             this->comm, MPI_STATUS_IGNORE);
+                    if (NextProc != 0)
+                        MPI_Send(&MaxBoundExchanges, 1, MPI_LONG_LONG, NextProc, Collective::MessageType::FINAL,
+                                 this->comm);
+                    break;
+                }
             }
         }
-        MPI_Barrier(MPI_COMM_WORLD);
 
         ///                       Cleanup                          ///
-        for (int i = 0; i < num; i++) {
-            IdleProcAsksForWork = 0;
-            MPI_Iprobe(MPI_ANY_SOURCE, Collective::MessageType::IDLE_PROC_WANTS_WORK, MPI_COMM_WORLD,
-                       &IdleProcAsksForWork, &st); // test if another processor has sent me a request
+        // every process has to take part in the same number of bound exchanges, they differ by at most one.
+        // Nonblocking collectives only match nonblocking ones so the missing ones are started the same way
+        if (IallreduceOngoing)
+            MPI_Wait(&boundexchangeReq, MPI_STATUS_IGNORE);
+        for (; BoundExchanges < MaxBoundExchanges; BoundExchanges++) {
+            MPI_Iallreduce(&LocalBoundToShare, &GlobalBestBound, 1, ConvertTypeToMPIType<Domain_Type>(), BestOf,
+                           this->comm, &boundexchangeReq);
+            MPI_Wait(&boundexchangeReq, MPI_STATUS_IGNORE);
+        }
+
+        // requests sent before TERMINATE are answered (with empty packages) until every process got its answer
+        MPI_Request barrierReq = MPI_REQUEST_NULL;
+        while (true) {
+            MPI_Iprobe(MPI_ANY_SOURCE, Collective::MessageType::IDLE_PROC_WANTS_WORK, this->comm,
+                       &IdleProcAsksForWork, &st);
             if (IdleProcAsksForWork == 1) {
-                MPI_Recv(buffer, 1, MPI_CHAR, st.MPI_SOURCE, Collective::MessageType::IDLE_PROC_WANTS_WORK,
-                         MPI_COMM_WORLD, &st);
-                printProc("CLEARNUP SUCCESSFULL " << __LINE__)
+                int target = st.MPI_SOURCE;
+                char anything;
+                MPI_Recv(&anything, 1, MPI_CHAR, target, Collective::MessageType::IDLE_PROC_WANTS_WORK,
+                         this->comm, &st);
+                if (ShareRequest_ongoing[target]) MPI_Wait(&ShareRequests[target], MPI_STATUS_IGNORE);
+                sendbuffers[target].Clear();
+                sendbuffers[target].Write(LocalBestBound);
+                encoder.Encode_Package(sendbuffers[target], {});
+                MPI_Issend(sendbuffers[target].Data(), sendbuffers[target].Size(), MPI_CHAR, target,
+                           Collective::MessageType::WORK_EXCHANGE, this->comm, &ShareRequests[target]);
+                ShareRequest_ongoing[target] = true;
             }
-
-            int requestReceived = 0;
-            MPI_Iprobe(MPI_ANY_SOURCE, Collective::MessageType::WORK_EXCHANGE, MPI_COMM_WORLD,
-                       &requestReceived, &st); // test if another processor has sent me a request
-            if (requestReceived == 1) {
-                MPI_Recv(buffer, 100000, MPI_CHAR, st.MPI_SOURCE, Collective::MessageType::WORK_EXCHANGE,
-                         MPI_COMM_WORLD, &throwAway);
-                printProc("CLEARNUP SUCCESSFULL " << __LINE__)
+            if (RequestSent) {
+                int requestReceived = 0;
+                MPI_Test(&workReq, &requestReceived, MPI_STATUS_IGNORE);
+                if (requestReceived == 1) {
+                    assert(ProcWhomISend >= 0 && "an open steal request has a victim");
+                    ReceiveMessage(receivbuffer, ProcWhomISend, Collective::MessageType::WORK_EXCHANGE, throwAway,
+                                   this->comm);
+                    RequestSent = false;
+                }
+            } else if (barrierReq == MPI_REQUEST_NULL) {
+                MPI_Ibarrier(this->comm, &barrierReq);
+            } else {
+                int done = 0;
+                MPI_Test(&barrierReq, &done, MPI_STATUS_IGNORE);
+                if (done == 1) break;
             }
-
         }
-
-        MPI_Barrier(MPI_COMM_WORLD);
-        // receive possible messages
         for (int i = 0; i < num; i++)
-            if (ShareRequest_ongoing[i]) {
-                MPI_Request_free(&ShareRequests[i]);
-            }
-        if (workReq != MPI_REQUEST_NULL) {
-            MPI_Request_free(&workReq);
+            if (ShareRequest_ongoing[i]) MPI_Wait(&ShareRequests[i], MPI_STATUS_IGNORE);
+        if (UseNodePool) pool.Finish();
+
+        // nothing is in flight anymore, so the queues hold all open subproblems. A process can end the search
+        // without having seen the cancel, so they agree whether to write
+        if (!CheckpointPath.empty()) {
+            int Cancelled = this->control->IsCancelled(), Write;
+            MPI_Allreduce(&Cancelled, &Write, 1, MPI_INT, MPI_LOR, this->comm);
+            if (Write)
+                checkpoint.Write(CheckpointPath, this->comm, encoder, LocalTaskQueue, LocalBestBound, BestSubproblem,
+                                 NumProblemsSolved);
         }
 
         printProc("I have sent " << NumMessages << " messages and solved " << NumProblemsSolved << " problems");
+        printProc("I have stolen " << LocalSteals << " times on my node and " << RemoteSteals
+                                   << " times from other nodes (" << FailedRemoteSteals << " failed), "
+                                   << 100.0 * LocalSteals / std::max(1, LocalSteals + RemoteSteals) << "% stayed local");
+        this->stats.Solved = NumProblemsSolved;
+        this->stats.Steals = LocalSteals + RemoteSteals;
+
+        this->FinishSearch();
 
         // ------------------------ ALL procs have a best solution now master has to gather it
-        return ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(sendstreams[pid], receivstream,
-                                                                                BestSubproblem,
-                                                                                Problem_Def,
-                                                                                prob,
-                                                                                encoder,
-                                                                                goal);
+        BestSubproblem = ExtractBestSolution<Prob_Consts, Subproblem_Params, Domain_Type>(sendbuffers[pid], receivbuffer,
+                                                                                          BestSubproblem,
+                                                                                          Problem_Def,
+                                                                                          prob,
+                                                                                          encoder,
+                                                                                          goal,
+                                                                                          this->comm,
+                                                                                          this->BroadcastSolution);
+        if (pid == 0)
+            this->control->Improved(Problem_Def.GetContainedUpperBound(prob, BestSubproblem), BestSubproblem);
+        return BestSubproblem;
     }
 
 }
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "Base.h"
+#include "MPI_Message_Encoder.h"
+
+namespace BnB {
+    enum class Publication {
+        DONE, FULL, TOO_BIG // TOO_BIG subproblems need more slots than the ring has
+    };
+
+    // ring of encoded subproblems in an MPI window that other processes take from without the owner's help.
+    // The owner appends at the tail, takers claim a range at the head with MPI_Compare_and_swap and copy it out
+    // with MPI_Get. A subproblem takes as many consecutive slots as it needs. Every slot has a state, the number
+    // of slots of its subproblem or 0, so takers find where subproblems begin and the owner only reuses a slot
+    // after its taker has copied it.
+    // Process 0 additionally holds the counter of the open subproblems of the whole search.
+    // All accesses are one-sided inside one lock_all epoch that lasts for the whole search.
+    // Started with StartNode the ring only spans the processes of one node. The window is then shared memory
+    // and takers copy the slots directly, only the indices and states are updated with MPI atomics
+    template<typename Subproblem_Params>
+    class MPI_Task_Ring {
+    public:
+        ~MPI_Task_Ring() {
+            // a ring that outlives MPI_Finalize cannot free its window anymore
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized) Release();
+        }
+
+        // called by all processes of communicator before the search, InitialWork is the start value of the counter.
+        // The window of the last search is reused if it has the same processes and layout
+        void Start(int NumSlots, int BytesPerSlot, long long InitialWork, MPI_Comm communicator) {
+            if (!Fits(NumSlots, BytesPerSlot, false, communicator)) {
+                Release();
+                comm = Parent = communicator;
+                OwnComm = false;
+                Allocate(NumSlots, BytesPerSlot, false);
+            }
+            Clear();
+            if (pid == 0) std::memcpy(memory + COUNTER, &InitialWork, sizeof(long long));
+            Open();
+        }
+
+        // called by all processes before the search, every process gets a ring that only the processes on its
+        // node take from. Victims are then given by their rank within the node
+        void StartNode(int NumSlots, int BytesPerSlot, MPI_Comm communicator) {
+            if (!Fits(NumSlots, BytesPerSlot, true, communicator)) {
+                Release();
+                int parentpid;
+                MPI_Comm_rank(communicator, &parentpid);
+                MPI_Comm_split_type(communicator, MPI_COMM_TYPE_SHARED, parentpid, MPI_INFO_NULL, &comm);
+                OwnComm = true;
+                Parent = communicator;
+                Allocate(NumSlots, BytesPerSlot, true);
+            }
+            Clear();
+            Open();
+        }
+
+        // called by all processes after the search. The window stays for the next search, the barrier makes sure
+        // nobody still reads it when it is cleared for that
+        void Finish() {
+            MPI_Win_unlock_all(win);
+            MPI_Barrier(comm);
+        }
+
+        // frees the window, called by all processes. The next Start allocates a new one
+        void Release() {
+            if (win == MPI_WIN_NULL) return;
+            MPI_Win_free(&win);
+            if (OwnComm) MPI_Comm_free(&comm);
+            OwnComm = false;
+            Parent = MPI_COMM_NULL;
+        }
+
+        // rank and number of the processes that share the rings, all processes unless started with StartNode
+        int Rank() const { return pid; }
+        int Size() const { return static_cast<int>(peers.size()); }
+
+        // number of slots in the own ring that nobody has claimed yet
+        int Published() {
+            unsigned Head;
+            MPI_Fetch_and_op(nullptr, &Head, MPI_UNSIGNED, pid, HEAD, MPI_NO_OP, win);
+            MPI_Win_flush(pid, win);
+            return static_cast<int>(Tail - Head);
+        }
+
+        // appends a subproblem to the own ring
+        Publication Publish(const Subproblem_Params &params, const MPI_Message_Encoder<Subproblem_Params> &encoder) {
+            int slot = static_cast<int>(Tail % Slots);
+            // a full slot at the tail means a full ring, the subproblem does not have to be encoded then
+            ReadStates(pid, slot, 1);
+            if (states[0] != EMPTY) return Publication::FULL;
+
+            scratch.Clear();
+            encoder.Encode_Solution(scratch, params);
+            int length = scratch.Size();
+            int bytes = static_cast<int>(sizeof(int)) + length;
+            int span = (bytes + SlotBytes - 1) / SlotBytes;
+            if (span > Slots) return Publication::TOO_BIG;
+            ReadStates(pid, slot, span);
+            for (int i = 0; i < span; i++)
+                if (states[i] != EMPTY) return Publication::FULL;
+
+            // the slots are free so nobody reads them, the owner writes them directly. Data, states and tail are
+            // made visible in this order, the sync and the flushes complete each step before the next
+            entry.resize(bytes);
+            std::memcpy(entry.data(), &length, sizeof(int));
+            std::memcpy(entry.data() + sizeof(int), scratch.Data(), length);
+            int first = std::min(bytes, (Slots - slot) * SlotBytes);
+            std::memcpy(memory + DATA(slot), entry.data(), first);
+            std::memcpy(memory + DATA(0), entry.data() + first, bytes - first);
+            MPI_Win_sync(win);
+            WriteStates(pid, slot, std::vector<unsigned>(span, static_cast<unsigned>(span)));
+            Tail += span;
+            MPI_Accumulate(&Tail, 1, MPI_UNSIGNED, pid, TAIL, 1, MPI_UNSIGNED, MPI_REPLACE, win);
+            MPI_Win_flush(pid, win);
+            return Publication::DONE;
+        }
+
+        // claims half of the subproblems in the ring of victim (which can be the own ring) and appends
+        // them to Taken. Returns the number of claimed subproblems, 0 if the ring is empty or another
+        // process claimed the same range first
+        int Take(int victim, std::vector<Subproblem_Params> &Taken,
+                 const MPI_Message_Encoder<Subproblem_Params> &encoder) {
+            unsigned Ends[2]; // head and tail
+            MPI_Get_accumulate(nullptr, 0, MPI_UNSIGNED, Ends, 2, MPI_UNSIGNED, victim, HEAD, 2, MPI_UNSIGNED,
+                               MPI_NO_OP, win);
+            MPI_Win_flush(victim, win);
+            unsigned Head = Ends[0];
+            // the two values are read one after the other, a head that passed the tail read before means empty
+            int available = static_cast<int>(Ends[1] - Head);
+            if (available <= 0) return 0;
+
+            // the states of the slots before the tail are set before the tail, so they show where the
+            // subproblems begin. If another taker is faster they can change, then the walk may stop anywhere
+            // but the compare and swap below fails anyway
+            int first = static_cast<int>(Head % Slots);
+            ReadStates(victim, first, available);
+            std::vector<int> spans;
+            for (int pos = 0; pos < available && states[pos] != EMPTY; pos += spans.back()) {
+                if (pos + static_cast<int>(states[pos]) > available) break;
+                spans.push_back(static_cast<int>(states[pos]));
+            }
+            if (spans.empty()) return 0;
+            spans.resize((spans.size() + 1) / 2);
+            int count = 0;
+            for (int span : spans) count += span;
+
+            unsigned NewHead = Head + count, Old;
+            MPI_Compare_and_swap(&NewHead, &Head, &Old, MPI_UNSIGNED, victim, HEAD, win);
+            MPI_Win_flush(victim, win);
+            if (Old != Head) return 0;
+
+            // the claimed slots may wrap around the end of the ring
+            int parts[2] = {std::min(count, Slots - first), count - std::min(count, Slots - first)};
+            int starts[2] = {first, 0};
+            slots.resize(static_cast<size_t>(count) * SlotBytes);
+            // in shared memory the sync makes the data the owner wrote before its tail visible here
+            if (Shared) MPI_Win_sync(win);
+            for (int p = 0, offset = 0; p < 2; offset += parts[p], p++) {
+                if (parts[p] == 0) continue;
+                char *dst = slots.data() + static_cast<size_t>(offset) * SlotBytes;
+                if (Shared)
+                    std::memcpy(dst, peers[victim] + DATA(starts[p]), static_cast<size_t>(parts[p]) * SlotBytes);
+                else
+                    MPI_Get(dst, parts[p] * SlotBytes, MPI_CHAR, victim, DATA(starts[p]), parts[p] * SlotBytes,
+                            MPI_CHAR, win);
+            }
+            if (!Shared) MPI_Win_flush(victim, win);
+
+            // hands the slots back to the owner
+            WriteStates(victim, first, std::vector<unsigned>(count, EMPTY));
+
+            // copied in ring order, a subproblem that wrapped around the end is contiguous again
+            for (int i = 0, offset = 0; i < static_cast<int>(spans.size()); offset += spans[i], i++) {
+                const char *slot = slots.data() + static_cast<size_t>(offset) * SlotBytes;
+                int length;
+                std::memcpy(&length, slot, sizeof(int));
+                std::memcpy(scratch.Receive(length), slot + sizeof(int), length);
+                Taken.emplace_back();
+                encoder.Decode_Solution(scratch, Taken.back());
+            }
+            return static_cast<int>(spans.size());
+        }
+
+        // adds delta to the counter of open subproblems on process 0
+        void AddWork(long long delta) {
+            MPI_Accumulate(&delta, 1, MPI_LONG_LONG, 0, COUNTER, 1, MPI_LONG_LONG, MPI_SUM, win);
+            MPI_Win_flush(0, win);
+        }
+
+        long long OpenWork() {
+            long long Work;
+            MPI_Fetch_and_op(nullptr, &Work, MPI_LONG_LONG, 0, COUNTER, MPI_NO_OP, win);
+            MPI_Win_flush(0, win);
+            return Work;
+        }
+
+        // a node ring has no counter of open subproblems, its counter on process 0 instead tells if a process of
+        // the node holds subproblems that are too big for a ring. The others can only get them by message then
+        void Overflow() { AddWork(1); }
+        bool Overflowing() { return OpenWork() > 0; }
+
+    private:
+        // reads the states of count slots from first on in the ring of owner into states, they may wrap around
+        void ReadStates(int owner, int first, int count) {
+            states.resize(count);
+            int parts[2] = {std::min(count, Slots - first), count - std::min(count, Slots - first)};
+            int starts[2] = {first, 0};
+            for (int p = 0, offset = 0; p < 2; offset += parts[p], p++)
+                if (parts[p] > 0)
+                    MPI_Get_accumulate(nullptr, 0, MPI_UNSIGNED, states.data() + offset, parts[p], MPI_UNSIGNED,
+                                       owner, STATE(starts[p]), parts[p], MPI_UNSIGNED, MPI_NO_OP, win);
+            MPI_Win_flush(owner, win);
+        }
+
+        // replaces the states of Values.size() slots from first on in the ring of owner
+        void WriteStates(int owner, int first, const std::vector<unsigned> &Values) {
+            int count = static_cast<int>(Values.size());
+            int parts[2] = {std::min(count, Slots - first), count - std::min(count, Slots - first)};
+            int starts[2] = {first, 0};
+            for (int p = 0, offset = 0; p < 2; offset += parts[p], p++)
+                if (parts[p] > 0)
+                    MPI_Accumulate(Values.data() + offset, parts[p], MPI_UNSIGNED, owner, STATE(starts[p]),
+                                   parts[p], MPI_UNSIGNED, MPI_REPLACE, win);
+            MPI_Win_flush(owner, win);
+        }
+
+        // every ring gets the same layout, the slots are rounded up to a power of two which keeps the slot of
+        // an index right when the indices wrap around
+        void Allocate(int NumSlots, int BytesPerSlot, bool InSharedMemory) {
+            Slots = RoundedSlots(NumSlots);
+            SlotBytes = BytesPerSlot;
+            Shared = InSharedMemory;
+            int num;
+            MPI_Comm_rank(comm, &pid);
+            MPI_Comm_size(comm, &num);
+            MPI_Aint size = DATA(Slots);
+            peers.assign(num, nullptr);
+            if (Shared) {
+                MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, comm, &memory, &win);
+                for (int i = 0; i < num; i++) {
+                    MPI_Aint PeerSize;
+                    int DispUnit;
+                    MPI_Win_shared_query(win, i, &PeerSize, &DispUnit, &peers[i]);
+                }
+            } else {
+                MPI_Win_allocate(size, 1, MPI_INFO_NULL, comm, &memory, &win);
+            }
+        }
+
+        static int RoundedSlots(int NumSlots) {
+            int rounded = 1;
+            while (rounded < NumSlots) rounded *= 2;
+            return rounded;
+        }
+
+        // the window of the last search can be used again, all processes come to the same answer
+        bool Fits(int NumSlots, int BytesPerSlot, bool InSharedMemory, MPI_Comm communicator) const {
+            return win != MPI_WIN_NULL && Parent == communicator && Shared == InSharedMemory
+                   && Slots == RoundedSlots(NumSlots) && SlotBytes == BytesPerSlot;
+        }
+
+        // empties the own ring, nobody accesses it outside of a search
+        void Clear() {
+            Tail = 0;
+            std::memset(memory, 0, DATA(Slots));
+        }
+
+        void Open() {
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+            // the initial values have to be in the window before anybody accesses it
+            MPI_Win_sync(win);
+            MPI_Barrier(comm);
+        }
+
+        // layout of the window in bytes: head, tail, counter, one state per slot, the slots.
+        // Head and tail only ever grow and wrap around, 32 bit indices are enough as only their difference counts
+        static constexpr MPI_Aint HEAD = 0;
+        static constexpr MPI_Aint TAIL = sizeof(unsigned);
+        static constexpr MPI_Aint COUNTER = 2 * sizeof(unsigned);
+        MPI_Aint STATE(int slot) const { return COUNTER + sizeof(long long) + slot * sizeof(unsigned); }
+        MPI_Aint DATA(int slot) const {
+            return (STATE(Slots) + sizeof(long long) - 1) / sizeof(long long) * sizeof(long long)
+                   + static_cast<MPI_Aint>(slot) * SlotBytes;
+        }
+
+        static constexpr unsigned EMPTY = 0;
+
+        int Slots = 0;
+        int SlotBytes = 0;
+        int pid = 0; // rank in comm
+        unsigned Tail = 0; // only changed by the owner, so it keeps a local copy
+        MPI_Comm comm = MPI_COMM_WORLD;
+        MPI_Comm Parent = MPI_COMM_NULL; // communicator the ring was started with
+        bool OwnComm = false; // the node communicator is freed with the ring
+        bool Shared = false;
+        MPI_Win win = MPI_WIN_NULL;
+        char *memory = nullptr; // own part of the window
+        std::vector<char *> peers; // parts of the other processes, only known in shared memory
+        MPI_Buffer scratch;
+        std::vector<char> slots;
+        std::vector<char> entry;
+        std::vector<unsigned> states;
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <omp.h>
+#include <iterator>
+#include "Base.h"
+#include "BnB_Serial_Solver.h"
+#include "BnB_OMP_Solver.h"
+
+namespace BnB {
+
+    // solves many independent instances of the same problem at once
+    // small instances are the unit of parallelism: every thread takes the next unsolved instance and
+    // solves it serially, threads that finish early simply take the next one (dynamic load balancing).
+    // Large instances, as judged by the measure given to LargeInstances, are solved afterwards one by
+    // one with all threads working on the same tree.
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    class Solver_Batch {
+    public:
+        // gets called for every instance as soon as it is solved, so the order is the completion order
+        // calls never overlap, the callback does not need to be thread safe
+        using Result_Callback = std::function<void(size_t Index, const Subproblem_Params &Solution)>;
+
+        void SetNumThreads(int num) { numThreads = num; }
+
+        // instances with measure(consts) >= threshold are solved with intra-instance parallelism
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *
+        LargeInstances(std::function<size_t(const Problem_Consts &)> measure, size_t threshold) {
+            Measure = measure;
+            Threshold = threshold;
+            return this;
+        }
+
+        // the parameters are kept by the batch and handed to the serial solvers of the small instances and to the
+        // solver of the large ones before every batch, so they also survive SetScheduler
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *SetSchedulerParameters() { return this; }
+
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *Eps(Domain_Type e) {EPS = e; return this;}
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *Traversal(TraversalMode m) {mode = m; return this;}
+        // only used for the large instances, see OMP_Scheduler
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *Affinity(OMP_Affinity a) {affinity = a; return this;}
+        Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type> *NumaDomains(int num) {numaDomains = num; return this;}
+
+        void SetScheduler(OMP_Scheduler_Type type) { LargeSolver.SetScheduler(type); }
+
+        // solves all instances in [first, last), Index in the callback is the offset from first
+        template<typename RandomIt>
+        void Maximize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                      RandomIt first, RandomIt last, const Result_Callback &callback) {
+            Solve(Problem_Def, first, last, Goal::MAX, callback);
+        }
+
+        template<typename RandomIt>
+        void Minimize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                      RandomIt first, RandomIt last, const Result_Callback &callback) {
+            Solve(Problem_Def, first, last, Goal::MIN, callback);
+        }
+
+    private:
+        template<typename RandomIt>
+        void Solve(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                   RandomIt first, RandomIt last, Goal goal, const Result_Callback &callback);
+
+        int numThreads = 1;
+        std::function<size_t(const Problem_Consts &)> Measure = nullptr;
+        size_t Threshold = std::numeric_limits<size_t>::max();
+
+        // same defaults as Serial_Scheduler
+        Domain_Type EPS = static_cast<Domain_Type>(0.001);
+        TraversalMode mode = TraversalMode::DFS;
+        OMP_Affinity affinity = OMP_Affinity::NONE;
+        int numaDomains = 1;
+
+        // one serial solver per thread, they are kept so that repeated batches reuse them
+        std::vector<Solver_Serial<Problem_Consts, Subproblem_Params, Domain_Type>> SmallSolvers;
+        Solver_OMP<Problem_Consts, Subproblem_Params, Domain_Type> LargeSolver;
+    };
+
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    template<typename RandomIt>
+    void Solver_Batch<Problem_Consts, Subproblem_Params, Domain_Type>::Solve(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            RandomIt first, RandomIt last, Goal goal, const Result_Callback &callback) {
+        long NumInstances = std::distance(first, last);
+
+        // split into instances that are solved whole by one thread and those that need all threads
+        std::vector<size_t> Small, Large;
+        for (long i = 0; i < NumInstances; i++) {
+            if (Measure && Measure(first[i]) >= Threshold)
+                Large.push_back(i);
+            else
+                Small.push_back(i);
+        }
+
+        if (SmallSolvers.size() < (size_t) numThreads)
+            SmallSolvers.resize(numThreads);
+        for (auto &solver : SmallSolvers)
+            solver.SetSchedulerParameters()->Eps(EPS)->TraversMode(mode);
+        LargeSolver.SetSchedulerParameters()->Eps(EPS)->Traversal(mode)->Affinity(affinity)->NumaDomains(numaDomains);
+
+        long NumSmall = Small.size();
+        omp_set_dynamic(0);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+        for (long i = 0; i < NumSmall; i++) {
+            auto &solver = SmallSolvers[omp_get_thread_num()];
+            const Problem_Consts &prob = first[Small[i]];
+            Subproblem_Params Solution = goal == Goal::MAX ? solver.Maximize(Problem_Def, prob)
+                                                           : solver.Minimize(Problem_Def, prob);
+#pragma omp critical(BnB_Batch_Result)
+            callback(Small[i], Solution);
+        }
+
+        LargeSolver.SetNumThreads(numThreads);
+        for (size_t index : Large) {
+            const Problem_Consts &prob = first[index];
+            Subproblem_Params Solution = goal == Goal::MAX ? LargeSolver.Maximize(Problem_Def, prob)
+                                                           : LargeSolver.Minimize(Problem_Def, prob);
+            callback(index, Solution);
+        }
+    }
+}
@@ -33,8 +33,13 @@ namespace BnB {
                  const Problem_Consts &prob);
 
     private:
+        // sets up the runtime only when the number of threads changed, repeated solves skip this
+        void PrepareThreads();
+
         // number of threads that will be used for execution
         size_t numThreads = 1;
+        // number of threads the runtime was set up with, 0 if it was never set up
+        size_t configuredThreads = 0;
 
         std::unique_ptr<OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>> scheduler =
                 std::make_unique<OMP_Scheduler_Tasking<Problem_Consts, Subproblem_Params, Domain_Type>>();
@@ -46,8 +51,8 @@ namespace BnB {
             const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
             const Problem_Consts &prob) {
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::lowest();
-        omp_set_dynamic(0);
-        omp_set_num_threads(numThreads);
+        PrepareThreads();
+        scheduler->Control(this->control);
         Subproblem_Params result = scheduler->Execute(Problem_Def, prob, Goal::MAX, WorstSolution);
         std::cout << "threads are set to " << numThreads << std::endl;
         return result;
@@ -58,13 +63,22 @@ namespace BnB {
             const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
             const Problem_Consts &prob) {
         Domain_Type WorstSolution = std::numeric_limits<Domain_Type>::max();
-        omp_set_dynamic(0);
-        omp_set_num_threads(numThreads);
+        PrepareThreads();
+        scheduler->Control(this->control);
         Subproblem_Params result = scheduler->Execute(Problem_Def, prob, Goal::MIN, WorstSolution);
         std::cout << "threads are set to " << numThreads << std::endl;
         return result;
     }
 
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    void Solver_OMP<Problem_Consts, Subproblem_Params, Domain_Type>::PrepareThreads() {
+        if (configuredThreads == numThreads && omp_get_max_threads() == (int) numThreads)
+            return;
+        omp_set_dynamic(0);
+        omp_set_num_threads(numThreads);
+        configuredThreads = numThreads;
+    }
+
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     void Solver_OMP<Problem_Consts, Subproblem_Params, Domain_Type>::SetScheduler(OMP_Scheduler_Type type) {
         switch (type) {
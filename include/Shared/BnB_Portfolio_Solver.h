@@ -0,0 +1,200 @@
+#pragma once
+#include <omp.h>
+#include <atomic>
+#include "Base.h"
+#include "BnB_Solver.h"
+#include "Incumbent.h"
+
+namespace BnB {
+
+    // one configuration of the portfolio, it explores the whole tree on its own
+    template<typename Domain_Type>
+    struct Portfolio_Strategy {
+        TraversalMode mode = TraversalMode::DFS;
+        Domain_Type eps = 0;
+        // expand the open subproblem with the best estimate first, mode is ignored then
+        bool BestFirst = false;
+    };
+
+    // racing solver: every strategy runs on its own thread and searches the full tree,
+    // all of them prune against one shared incumbent so every strategy profits from the solutions
+    // of the others. The first strategy with eps 0 that empties its queue has proven the incumbent
+    // optimal and stops the others. A strategy with a bigger eps only stops them if no strategy is exact.
+    // If the runtime gives fewer threads than strategies, the threads take the strategies round-robin
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    class Solver_Portfolio : public Solver<Problem_Consts, Subproblem_Params, Domain_Type> {
+    public:
+        // adds a strategy that takes nodes from its queue according to mode
+        Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type> *AddStrategy(TraversalMode mode, Domain_Type eps) {
+            strategies.push_back({mode, eps, false});
+            return this;
+        }
+
+        // adds a strategy that always expands the node with the best estimate
+        Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type> *AddBestFirstStrategy(Domain_Type eps) {
+            strategies.push_back({TraversalMode::DFS, eps, true});
+            return this;
+        }
+
+        // index of the strategy that ended the last race, -1 if none did (e.g. it was cancelled)
+        int Winner() const { return winner; }
+
+        Subproblem_Params
+        Maximize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                 const Problem_Consts &prob);
+
+        Subproblem_Params
+        Minimize(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                 const Problem_Consts &prob);
+
+    private:
+        Subproblem_Params Race(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                               const Problem_Consts &prob,
+                               const Goal goal,
+                               const Domain_Type WorstBound);
+
+        void RunStrategy(const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+                         const Problem_Consts &prob,
+                         const Goal goal,
+                         int id);
+
+        std::vector<Portfolio_Strategy<Domain_Type>> strategies;
+        Atomic_Incumbent<Subproblem_Params, Domain_Type> incumbent;
+        std::atomic<bool> Finished{false};
+        // a strategy with eps 0 is in the race, only those can end it
+        bool AnyExact = false;
+        int winner = -1;
+    };
+
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type>::Maximize(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Problem_Consts &prob) {
+        return Race(Problem_Def, prob, Goal::MAX, std::numeric_limits<Domain_Type>::lowest());
+    }
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type>::Minimize(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Problem_Consts &prob) {
+        return Race(Problem_Def, prob, Goal::MIN, std::numeric_limits<Domain_Type>::max());
+    }
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    Subproblem_Params Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type>::Race(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Problem_Consts &prob,
+            const Goal goal,
+            const Domain_Type WorstBound) {
+        if (strategies.empty()) {
+            AddStrategy(TraversalMode::DFS, 0);
+            AddStrategy(TraversalMode::BFS, 0);
+            AddBestFirstStrategy(0);
+        }
+        incumbent.Reset(goal, WorstBound);
+        this->control->Start(goal, WorstBound,
+                             std::get<0>(Problem_Def.GetEstimateForBounds(prob, Problem_Def.GetInitialSubproblem(prob))));
+        Finished = false;
+        winner = -1;
+        AnyExact = std::any_of(strategies.begin(), strategies.end(),
+                               [](const Portfolio_Strategy<Domain_Type> &s) { return s.eps == 0; });
+
+        // the caller's setting is restored, num_threads is only an upper bound anyway
+        int dynamic = omp_get_dynamic();
+        omp_set_dynamic(0);
+#pragma omp parallel num_threads(strategies.size())
+        {
+            for (size_t id = omp_get_thread_num(); id < strategies.size(); id += omp_get_num_threads())
+                RunStrategy(Problem_Def, prob, goal, id);
+        }
+        omp_set_dynamic(dynamic);
+        this->control->Finish();
+
+        if (winner == -1)
+            std::cout << "no strategy finished the search" << std::endl;
+        else if (strategies[winner].eps == 0)
+            std::cout << "strategy " << winner << " proved optimality first" << std::endl;
+        else
+            std::cout << "strategy " << winner << " finished first, the solution is within " << strategies[winner].eps
+                      << " of the optimum" << std::endl;
+        Subproblem_Params BestSubproblem = incumbent.Solution();
+        Problem_Def.PrintSolution(BestSubproblem);
+        return BestSubproblem;
+    }
+
+    template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
+    void Solver_Portfolio<Problem_Consts, Subproblem_Params, Domain_Type>::RunStrategy(
+            const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
+            const Problem_Consts &prob,
+            const Goal goal,
+            int id) {
+        const Portfolio_Strategy<Domain_Type> &strategy = strategies[id];
+
+        // best first keeps the estimate next to the node so it is computed only once
+        using Entry = std::pair<Domain_Type, Subproblem_Params>;
+        auto Compare = [goal](const Entry &a, const Entry &b) {
+            return (bool) goal ? a.first < b.first : a.first > b.first;
+        };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(Compare)> BestFirstQueue(Compare);
+        std::deque<Subproblem_Params> TaskQueue;
+
+        Subproblem_Params initial = Problem_Def.GetInitialSubproblem(prob);
+        if (strategy.BestFirst)
+            BestFirstQueue.push({std::get<0>(Problem_Def.GetEstimateForBounds(prob, initial)), initial});
+        else
+            TaskQueue.push_back(initial);
+
+        int NumProblemsSolved = 0;
+        while (!Finished.load(std::memory_order_relaxed) && !this->control->IsCancelled()) {
+            Subproblem_Params sol;
+            if (strategy.BestFirst) {
+                if (BestFirstQueue.empty()) break;
+                sol = BestFirstQueue.top().second;
+                BestFirstQueue.pop();
+            } else {
+                if (TaskQueue.empty()) break;
+                sol = GetNextSubproblem(TaskQueue, strategy.mode);
+            }
+            NumProblemsSolved++;
+
+            //ignore if its bound is worse than already known best sol.
+            auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, sol);
+            if (incumbent.IsPruned(LowerBound))
+                continue;
+
+            // try to make the bound better only if the solution lies in a feasible domain
+            auto Feasibility = Problem_Def.IsFeasible(prob, sol);
+            Domain_Type CandidateBound = UpperBound;
+            if (Feasibility == BnB::FEASIBILITY::Full) {
+                CandidateBound = Problem_Def.GetContainedUpperBound(prob, sol);
+                if (incumbent.Offer(CandidateBound, sol))
+                    this->control->Improved(CandidateBound, sol);
+            } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
+                CandidateBound = UpperBound;
+            } else if (Feasibility == BnB::FEASIBILITY::NONE)
+                continue;
+
+            if (std::abs(CandidateBound - LowerBound) > strategy.eps) { // epsilon criterion for convergence
+                std::vector<Subproblem_Params> v = Problem_Def.SplitSolution(prob, sol);
+                for (auto &&el : v) {
+                    if (strategy.BestFirst) {
+                        Domain_Type Estimate = std::get<0>(Problem_Def.GetEstimateForBounds(prob, el));
+                        if (!incumbent.IsPruned(Estimate))
+                            BestFirstQueue.push({Estimate, std::move(el)});
+                    } else {
+                        TaskQueue.push_back(std::move(el));
+                    }
+                }
+            }
+        }
+
+        // an empty queue means the whole tree was covered, the incumbent is optimal within the eps of the strategy
+        bool expected = false;
+        if ((strategy.BestFirst ? BestFirstQueue.empty() : TaskQueue.empty()) && (strategy.eps == 0 || !AnyExact)
+            && Finished.compare_exchange_strong(expected, true)) {
+            winner = id;
+        }
+        printProc("strategy " << id << " has solved " << NumProblemsSolved << " problems");
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <omp.h>
+#include <atomic>
+#include <vector>
+#include "Base.h"
+
+namespace BnB {
+
+    // how the threads of a parallel region are pinned to the hardware
+    // NONE    -- leave it to the runtime (threads may float between cores and sockets)
+    // COMPACT -- consecutive threads are packed onto neighbouring places (proc_bind(close))
+    // SCATTER -- consecutive threads are spread as far apart as possible (proc_bind(spread))
+    // pinning only has an effect if the runtime knows the places, e.g. OMP_PLACES=cores
+    enum class OMP_Affinity {
+        NONE, COMPACT, SCATTER
+    };
+
+    // opens a parallel region with the requested binding, proc_bind needs a compile time constant
+    // therefore every affinity has its own pragma
+    template<typename Body>
+    void ParallelRegion(OMP_Affinity affinity, int numThreads, Body &&body) {
+        switch (affinity) {
+            case OMP_Affinity::COMPACT:
+#pragma omp parallel num_threads(numThreads) proc_bind(close)
+                body();
+                break;
+            case OMP_Affinity::SCATTER:
+#pragma omp parallel num_threads(numThreads) proc_bind(spread)
+                body();
+                break;
+            case OMP_Affinity::NONE:
+#pragma omp parallel num_threads(numThreads)
+                body();
+                break;
+        }
+    }
+
+    // returns the NUMA domain of the calling thread, if the runtime knows its place we use it
+    // otherwise we derive it from the thread number and the way the threads were pinned
+    inline int DomainOfThread(OMP_Affinity affinity, int numDomains) {
+        if (numDomains <= 1) return 0;
+        int places = omp_get_num_places();
+        int place = omp_get_place_num();
+        if (places > 0 && place >= 0)
+            return place * numDomains / places;
+
+        int tid = omp_get_thread_num();
+        int team = omp_get_num_threads();
+        if (affinity == OMP_Affinity::SCATTER)
+            return tid % numDomains;
+        return tid * numDomains / team;
+    }
+
+    // holds one copy of the problem constants per NUMA domain, every copy is created by a thread
+    // of the domain it belongs to so that first-touch places its memory on the local socket
+    template<typename Problem_Consts>
+    class Problem_Consts_Replicas {
+    public:
+        void Replicate(const Problem_Consts &prob, int numDomains, OMP_Affinity affinity, int numThreads);
+
+        // constants that are closest to the calling thread
+        const Problem_Consts &Local() const {
+            if (Replicas.size() <= 1) return *Original;
+            return *Replicas[DomainOfThread(Affinity, Replicas.size())];
+        }
+
+        // constants of the given domain, the original if there are no copies
+        const Problem_Consts &Replica(int domain) const {
+            if (Replicas.size() <= 1) return *Original;
+            return *Replicas[domain];
+        }
+
+    private:
+        const Problem_Consts *Original = nullptr;
+        OMP_Affinity Affinity = OMP_Affinity::NONE;
+        std::vector<std::unique_ptr<Problem_Consts>> Replicas;
+    };
+
+    template<typename Problem_Consts>
+    void Problem_Consts_Replicas<Problem_Consts>::Replicate(const Problem_Consts &prob, int numDomains,
+                                                            OMP_Affinity affinity, int numThreads) {
+        Original = &prob;
+        Affinity = affinity;
+        Replicas.clear();
+        // a single domain reads the original, no copy needed
+        if (numDomains <= 1) return;
+
+        Replicas.resize(numDomains);
+        std::unique_ptr<std::atomic<bool>[]> Claimed(new std::atomic<bool>[numDomains]);
+        for (int i = 0; i < numDomains; i++)
+            Claimed[i] = false;
+
+        ParallelRegion(affinity, numThreads, [&]() {
+            int domain = DomainOfThread(affinity, numDomains);
+            bool expected = false;
+            if (Claimed[domain].compare_exchange_strong(expected, true))
+                Replicas[domain] = std::make_unique<Problem_Consts>(prob);
+        });
+
+        // domains that got no thread (fewer threads than domains) are filled by the calling thread
+        for (auto &replica : Replicas)
+            if (!replica) replica = std::make_unique<Problem_Consts>(prob);
+    }
+}
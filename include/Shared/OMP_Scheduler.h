@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Base.h"
+#include "OMP_Affinity.h"
+#include "Search_Control.h"
 
 namespace BnB{
     // strategy pattern that holds the actual MPI algorithm to schedule the work
@@ -8,6 +10,8 @@ namespace BnB{
     class OMP_Scheduler
     {
     public:
+        virtual ~OMP_Scheduler() = default;
+
         virtual Subproblem_Params Execute(
                 const Problem_Definition<Problem_Consts, Subproblem_Params, Domain_Type>& Problem_Def,
                 const Problem_Consts& prob,
@@ -16,9 +20,21 @@ namespace BnB{
 
         OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* Eps(Domain_Type e){eps = e;return this;}
         OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* Traversal(TraversalMode mode_){mode = mode_; return this;}
+        // pins the threads, see OMP_Affinity
+        OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* Affinity(OMP_Affinity a){affinity = a; return this;}
+        // number of NUMA domains that get their own copy of the problem constants, 1 means no copies
+        OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* NumaDomains(int num){numaDomains = num; return this;}
+        // the search reports its progress to this control and stops once it is cancelled
+        OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type>* Control(std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> c){control = std::move(c); return this;}
     protected:
         Domain_Type eps;
         TraversalMode mode = TraversalMode::DFS;
+        OMP_Affinity affinity = OMP_Affinity::NONE;
+        int numaDomains = 1;
+        // per domain copies of the constants, threads should always read replicas.Local()
+        Problem_Consts_Replicas<Problem_Consts> replicas;
+        std::shared_ptr<Search_Control<Subproblem_Params, Domain_Type>> control =
+                std::make_shared<Search_Control<Subproblem_Params, Domain_Type>>();
     };
 }
 
@@ -8,6 +8,9 @@ namespace BnB {
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     class OMP_Scheduler_Queue : public OMP_Scheduler<Problem_Consts, Subproblem_Params, Domain_Type> {
     public:
+        OMP_Scheduler_Queue() { omp_init_lock(&QueueLock); }
+        ~OMP_Scheduler_Queue() override { omp_destroy_lock(&QueueLock); }
+
         Subproblem_Params Execute(
                 const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
                 const Problem_Consts &prob,
@@ -17,16 +20,21 @@ namespace BnB {
     private:
         void ThreadWork(
                 const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
-                const Problem_Consts &prob,
                 const Subproblem_Params &task,
                 Subproblem_Params &CurrentBestProblem,
                 Domain_Type &BestBound,
                 std::deque<Subproblem_Params> &GlobalTaskQueue,
                 const Goal goal,
-                omp_lock_t &QueueLock);
+                omp_lock_t &QueueLock,
+                std::vector<Subproblem_Params> &Pool);
 
         int TasksWorkedOn = 0;
         int TasksEliminated = 0;
+        // the queue, its lock and the pools live as long as the scheduler so that repeated solves reuse them
+        std::deque<Subproblem_Params> GlobalTaskQueue;
+        omp_lock_t QueueLock;
+        // one staging pool per thread, its memory is first touched by the owning thread
+        std::vector<std::vector<Subproblem_Params>> ThreadPools;
     };
 
 
@@ -38,29 +46,38 @@ namespace BnB {
             Domain_Type WorstBound) {
         Subproblem_Params BestSubproblem;
         Domain_Type CurrentBestBound = WorstBound;
-        std::deque<Subproblem_Params> GlobalTaskQueue;
+        GlobalTaskQueue.clear();
         GlobalTaskQueue.push_back(Problem_Def.GetInitialSubproblem(prob));
-        omp_lock_t QueueLock;
-        omp_init_lock(&QueueLock);
+        this->control->Start(goal, WorstBound,
+                             std::get<0>(Problem_Def.GetEstimateForBounds(prob, GlobalTaskQueue.front())));
         TasksWorkedOn = 0;
         TasksEliminated = 0;
         std::cout << "max threads: " << omp_get_max_threads() << std::endl;
+        this->replicas.Replicate(prob, this->numaDomains, this->affinity, omp_get_max_threads());
+        ThreadPools.resize(omp_get_max_threads());
         while (!GlobalTaskQueue.empty()) {
             int NumTasks = GlobalTaskQueue.size();
             TasksWorkedOn += NumTasks;
 
-#pragma omp parallel for default(shared) schedule(static, 1) num_threads(omp_get_max_threads()) shared(QueueLock, CurrentBestBound)
-            for (int i = 0; i < NumTasks; i++) {
-                omp_set_lock(&QueueLock);
-                Subproblem_Params Task = GetNextSubproblem(GlobalTaskQueue, this->mode);
-                omp_unset_lock(&QueueLock);
+            ParallelRegion(this->affinity, omp_get_max_threads(), [&]() {
+                std::vector<Subproblem_Params> &Pool = ThreadPools[omp_get_thread_num()];
+#pragma omp for schedule(static, 1)
+                for (int i = 0; i < NumTasks; i++) {
+                    omp_set_lock(&QueueLock);
+                    Subproblem_Params Task = GetNextSubproblem(GlobalTaskQueue, this->mode);
+                    omp_unset_lock(&QueueLock);
 
-                ThreadWork(Problem_Def, prob, Task, BestSubproblem, CurrentBestBound, GlobalTaskQueue, goal, QueueLock);
-            }
+                    ThreadWork(Problem_Def, Task, BestSubproblem, CurrentBestBound, GlobalTaskQueue, goal,
+                               QueueLock, Pool);
+                }
+            });
+            // a cancelled search drops all open tasks
+            if (this->control->IsCancelled())
+                GlobalTaskQueue.clear();
         }
-        omp_destroy_lock(&QueueLock);
         std::cout << "There were " << TasksWorkedOn << " tasks generated by solving the problem" << std::endl;
         std::cout << "and so many were eliminated fast " << TasksEliminated << std::endl;
+        this->control->Finish();
         Problem_Def.PrintSolution(BestSubproblem);
         return BestSubproblem;
     }
@@ -69,16 +86,19 @@ namespace BnB {
     template<typename Problem_Consts, typename Subproblem_Params, typename Domain_Type>
     void OMP_Scheduler_Queue<Problem_Consts, Subproblem_Params, Domain_Type>::ThreadWork(
             const Problem_Definition <Problem_Consts, Subproblem_Params, Domain_Type> &Problem_Def,
-            const Problem_Consts &prob,
             const Subproblem_Params &task,
             Subproblem_Params &CurrentBestProblem,
             Domain_Type &CurrentBestBound,
             std::deque<Subproblem_Params> &GlobalTaskQueue,
             const Goal goal,
-            omp_lock_t &QueueLock) {
+            omp_lock_t &QueueLock,
+            std::vector<Subproblem_Params> &Pool) {
+        if (this->control->IsCancelled())
+            return;
+        const Problem_Consts &consts = this->replicas.Local();
 
         //ignore if its bound is worse than already known best sol.
-        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, task);
+        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(consts, task);
         if (((bool) goal && LowerBound < CurrentBestBound)
             || (!(bool) goal && LowerBound > CurrentBestBound)) {
             TasksEliminated++;
@@ -86,18 +106,22 @@ namespace BnB {
         }
 
         // try to make the bound better
-        auto Feasibility = Problem_Def.IsFeasible(prob, task);
+        auto Feasibility = Problem_Def.IsFeasible(consts, task);
         Domain_Type CandidateBound;
         if (Feasibility == BnB::FEASIBILITY::Full) {
-            CandidateBound = Problem_Def.GetContainedUpperBound(prob, task);
+            CandidateBound = Problem_Def.GetContainedUpperBound(consts, task);
+            bool Improved = false;
             #pragma omp critical
             {
                 if (((bool) goal && CandidateBound >= CurrentBestBound)
                 || (!(bool) goal && CandidateBound <= CurrentBestBound)) {
                     CurrentBestBound = CandidateBound;
                     CurrentBestProblem = task;
+                    Improved = true;
                 }
             }
+            if (Improved)
+                this->control->Improved(CandidateBound, task);
         } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
             CandidateBound = UpperBound;
         } else if (Feasibility == BnB::FEASIBILITY::NONE) {
@@ -108,20 +132,23 @@ namespace BnB {
         // check if we can divide further
         std::vector<Subproblem_Params> v;
         if (std::abs(CandidateBound - LowerBound) > this->eps) {
-            v = Problem_Def.SplitSolution(prob, task);
+            v = Problem_Def.SplitSolution(consts, task);
             for (auto &&el : v) {
                 // early bounding
-                auto[lower, upper] = Problem_Def.GetEstimateForBounds(prob, el);
+                auto[lower, upper] = Problem_Def.GetEstimateForBounds(consts, el);
                 if (((bool) goal && lower < CurrentBestBound)
                     || (!(bool) goal && lower > CurrentBestBound)) {
                     TasksEliminated++;
                     continue;
                 }
-
-                omp_set_lock(&QueueLock);
-                GlobalTaskQueue.push_back(el);
-                omp_unset_lock(&QueueLock);
+                Pool.push_back(std::move(el));
             }
+
+            // hand over all surviving children with a single lock
+            omp_set_lock(&QueueLock);
+            std::move(Pool.begin(), Pool.end(), std::back_inserter(GlobalTaskQueue));
+            omp_unset_lock(&QueueLock);
+            Pool.clear();
         }
     }
 }
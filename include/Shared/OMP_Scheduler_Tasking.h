@@ -36,26 +36,35 @@ namespace BnB {
             const Subproblem_Params &subpr) {
 #pragma omp atomic
         TasksWorkedOn++;
+        // a cancelled search drops all remaining tasks
+        if (this->control->IsCancelled())
+            return;
+        // tasks may run on any thread, so fetch the constants of the domain we are running on
+        const Problem_Consts &consts = this->replicas.Local();
         //ignore if its bound is worse than already known best sol.
-        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(prob, subpr);
+        auto[LowerBound, UpperBound] = Problem_Def.GetEstimateForBounds(consts, subpr);
         if (((bool) goal && LowerBound < BestBound)
             || (!(bool) goal && LowerBound > BestBound)) {
             return;
         }
 
         // try to make the bound better
-        auto Feasibility = Problem_Def.IsFeasible(prob, subpr);
+        auto Feasibility = Problem_Def.IsFeasible(consts, subpr);
         Domain_Type CandidateBound;
         if (Feasibility == BnB::FEASIBILITY::Full) {
-            CandidateBound = Problem_Def.GetContainedUpperBound(prob, subpr);
+            CandidateBound = Problem_Def.GetContainedUpperBound(consts, subpr);
+            bool Improved = false;
             #pragma omp critical
             {
                 if (((bool) goal && CandidateBound >= BestBound)
                 || (!(bool) goal && CandidateBound <= BestBound)) {
                     BestSubproblem = subpr;
                     BestBound = CandidateBound;
+                    Improved = true;
                 }
             }
+            if (Improved)
+                this->control->Improved(CandidateBound, subpr);
         } else if (Feasibility == BnB::FEASIBILITY::PARTIAL) {
             CandidateBound = UpperBound;
         } else if (Feasibility == BnB::FEASIBILITY::NONE)
@@ -63,9 +72,9 @@ namespace BnB {
 
         double diff = std::abs(CandidateBound - LowerBound);
         if (diff > this->eps) {
-            std::vector<Subproblem_Params> result = Problem_Def.SplitSolution(prob, subpr);
+            std::vector<Subproblem_Params> result = Problem_Def.SplitSolution(consts, subpr);
             for (const auto &r : result) {
-#pragma omp task firstprivate(r) shared(BestSubproblem, BestBound, Problem_Def, prob, goal) //priority(int(LowerBound))
+#pragma omp task firstprivate(r, goal) shared(BestSubproblem, BestBound, Problem_Def, prob) //priority(int(LowerBound))
                 {
                     DoTask(Problem_Def, prob, goal, BestSubproblem, BestBound, r);
                 }
@@ -84,19 +93,18 @@ namespace BnB {
             Domain_Type BestBound) {
         Subproblem_Params BestSubproblem;
         Subproblem_Params initial = Problem_Def.GetInitialSubproblem(prob);
+        this->control->Start(goal, BestBound, std::get<0>(Problem_Def.GetEstimateForBounds(prob, initial)));
+        this->replicas.Replicate(prob, this->numaDomains, this->affinity, omp_get_max_threads());
 
-#pragma omp parallel shared(BestBound, BestSubproblem)
-        {
+        ParallelRegion(this->affinity, omp_get_max_threads(), [&]() {
+            // the root is expanded directly, an extra task here would get private copies of the captured
+            // references which are gone once it finishes while its children are still running
 #pragma omp single
-            {
-#pragma omp task
-                {
-                    DoTask(Problem_Def, prob, goal, BestSubproblem, BestBound, initial);
-                }
-            }
+            DoTask(Problem_Def, prob, goal, BestSubproblem, BestBound, initial);
 #pragma omp taskwait
             printProc("I have worked on " << TasksWorkedOn << " Tasks");
-        }
+        });
+        this->control->Finish();
         Problem_Def.PrintSolution(BestSubproblem);
         return BestSubproblem;
     }
@@ -38,6 +38,45 @@ TEST(EncoderTest, VectorTest)
 	EXPECT_EQ(std::get<0>(receivedMessage)[2], 3) << "double encoding didnt work";
 }	
 
+TEST(EncoderTest, BinaryBasicTypeTest)
+{
+	MPI_Buffer buffer;
+
+	std::tuple<int, float, double> message {10, 20.5f, 30.25};
+
+	MPI_Message_Encoder<std::tuple<int, float, double>> encoder;
+	encoder.Encode_Solution(buffer, message);
+	EXPECT_EQ(buffer.Size(), sizeof(int) + sizeof(float) + sizeof(double)) << "binary encoding is not compact";
+
+	// other processor decoding now
+	std::tuple<int,float,double> receivedMessage;
+	buffer.Receive(buffer.Size());
+	encoder.Decode_Solution(buffer, receivedMessage);
+
+	EXPECT_EQ(receivedMessage, message) << "binary encoding didnt work";
+}
+
+TEST(EncoderTest, BinaryNestedVectorTest)
+{
+	MPI_Buffer buffer;
+
+	// layout of the TSP subproblems
+	using Params = std::tuple<std::vector<std::pair<int,int>>, std::vector<std::vector<int>>, int>;
+	Params message {{{0,1},{1,2}}, {{1,2,3},{4,5,6}}, 7};
+	MPI_Message_Encoder<Params> encoder;
+	encoder.Encode_Solution(buffer, message);
+	encoder.Encode_Solution(buffer, message);
+
+	// the buffer is read in the order it was written
+	Params first, second;
+	buffer.Receive(buffer.Size());
+	encoder.Decode_Solution(buffer, first);
+	encoder.Decode_Solution(buffer, second);
+
+	EXPECT_EQ(first, message) << "nested vector encoding didnt work";
+	EXPECT_EQ(second, message) << "second message in the buffer is broken";
+}
+
 int main(int argc, char* argv[])
 {
 	testing::InitGoogleTest(&argc, argv);
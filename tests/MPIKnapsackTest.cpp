@@ -1,7 +1,12 @@
 #include<gtest/gtest.h>
+#include <climits>
+#include <chrono>
+#include <thread>
 #include "../include/Core/Knapsack.h"
 #include "../include/Core/Base.h"
 #include "../include/Distributed/BnB_MPI_Solver.h"
+#include "../include/Distributed/BnB_MPI_Batch_Solver.h"
+#include "../include/Core/BnB_Session.h"
 
 
 int GetTotalValue(BnB::Knapsack::Params& t,BnB::Knapsack::Consts& C)
@@ -22,6 +27,98 @@ int GetTotalValue(BnB::Knapsack::Params& t,BnB::Knapsack::Consts& C)
     return std::get<3>(t);
 }
 
+// knapsack subproblems with 2 KB of padding, more than a slot of the task rings holds
+using PaddedParams = BnB::Subproblem_Parameters<std::vector<int>, int, int, float, std::vector<int>>;
+
+PaddedParams Pad(const BnB::Knapsack::Params& p)
+{
+    return {std::get<0>(p), std::get<1>(p), std::get<2>(p), std::get<3>(p), std::vector<int>(512, 1)};
+}
+
+BnB::Knapsack::Params Unpad(const PaddedParams& p)
+{
+    return {std::get<0>(p), std::get<1>(p), std::get<2>(p), std::get<3>(p)};
+}
+
+BnB::Problem_Definition<BnB::Knapsack::Consts, PaddedParams, int> GeneratePaddedProblem()
+{
+    auto Knapsack = BnB::Knapsack::GenerateToyProblem();
+    BnB::Problem_Definition<BnB::Knapsack::Consts, PaddedParams, int> Padded;
+    Padded.GetInitialSubproblem = [=](const BnB::Knapsack::Consts& c) { return Pad(Knapsack.GetInitialSubproblem(c)); };
+    Padded.SplitSolution = [=](const BnB::Knapsack::Consts& c, const PaddedParams& p) {
+        std::vector<PaddedParams> v;
+        for (const auto& el : Knapsack.SplitSolution(c, Unpad(p)))
+            v.push_back(Pad(el));
+        return v;
+    };
+    Padded.IsFeasible = [=](const BnB::Knapsack::Consts& c, const PaddedParams& p) { return Knapsack.IsFeasible(c, Unpad(p)); };
+    Padded.GetEstimateForBounds = [=](const BnB::Knapsack::Consts& c, const PaddedParams& p) {
+        return Knapsack.GetEstimateForBounds(c, Unpad(p));
+    };
+    Padded.GetContainedUpperBound = [=](const BnB::Knapsack::Consts& c, const PaddedParams& p) {
+        return Knapsack.GetContainedUpperBound(c, Unpad(p));
+    };
+    Padded.PrintSolution = [=](const PaddedParams& p) { Knapsack.PrintSolution(Unpad(p)); };
+    return Padded;
+}
+
+int Rank(MPI_Comm comm = MPI_COMM_WORLD)
+{
+    int id;
+    MPI_Comm_rank(comm, &id);
+    return id;
+}
+
+// a counter of every process combined, e.g. with MPI_SUM or MPI_MAX
+long long OverAll(long long Local, MPI_Op op, MPI_Comm comm = MPI_COMM_WORLD)
+{
+    long long Total;
+    MPI_Allreduce(&Local, &Total, 1, MPI_LONG_LONG, op, comm);
+    return Total;
+}
+
+// the optimum of a serial search, every scheduler has to find the same value
+template<typename Params>
+int Optimum(const BnB::Problem_Definition<BnB::Knapsack::Consts, Params, int>& Problem, const BnB::Knapsack::Consts& C)
+{
+    BnB::Solver_Serial<BnB::Knapsack::Consts, Params, int> solver;
+    solver.SetSchedulerParameters()->Eps(0);
+    return Problem.GetContainedUpperBound(C, solver.Maximize(Problem, C));
+}
+
+// solves on every process of comm, process 0 of comm checks that it got the optimum
+template<typename Params>
+void ExpectOptimum(BnB::Solver_MPI<BnB::Knapsack::Consts, Params, int>& solver,
+                   const BnB::Problem_Definition<BnB::Knapsack::Consts, Params, int>& Problem,
+                   const BnB::Knapsack::Consts& C, int Expected, const std::string& Message,
+                   MPI_Comm comm = MPI_COMM_WORLD)
+{
+    auto result = solver.Maximize(Problem, C);
+    if (Rank(comm) == 0)
+        EXPECT_EQ(Problem.GetContainedUpperBound(C, result), Expected) << Message;
+}
+
+// every split sleeps a little, so that with more processes and threads than cores the others get to run
+// while there is still work to give away
+template<typename Params>
+BnB::Problem_Definition<BnB::Knapsack::Consts, Params, int>
+Slowed(BnB::Problem_Definition<BnB::Knapsack::Consts, Params, int> Problem)
+{
+    auto Split = Problem.SplitSolution;
+    Problem.SplitSolution = [=](const BnB::Knapsack::Consts& C, const Params& p) {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        return Split(C, p);
+    };
+    return Problem;
+}
+
+// the counters of this process for the last solve
+template<typename Params>
+const BnB::MPI_Search_Stats& Stats(BnB::Solver_MPI<BnB::Knapsack::Consts, Params, int>& solver)
+{
+    return solver.SetSchedulerParameters()->Stats();
+}
+
 
 
 TEST(MPIKnapsack, someItemsFit)
@@ -83,11 +180,513 @@ TEST(MPIKnapsack, NoItemsFit)
     }
 }
 
+TEST(MPIKnapsack, SharedIncumbentWindow)
+{
+	// the window must not change the optimum, only how fast the workers learn about it
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 7);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::PRIORITY);
+	for (bool window : {false, true}) {
+		solver.SetSchedulerParameters()->Eps(0)->CommFrequency(5)->SharedIncumbent(window);
+		ExpectOptimum(solver, Problem, TestConsts, expected, "shared incumbent " + std::to_string(window) + " changed the result");
+		long long exchanges = OverAll(Stats(solver).WindowExchanges, MPI_SUM);
+		if (window) EXPECT_GT(exchanges, 0) << "the workers never used the window";
+		else EXPECT_EQ(exchanges, 0) << "the window was used without SharedIncumbent";
+	}
+}
+
+TEST(MPIKnapsack, OneSidedStealing)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 11);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+
+	// small rings so that the owners have to refill them while the others steal
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::ONESIDED);
+	static_cast<BnB::MPI_Scheduler_OneSided<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0))->RingSlots(4);
+	ExpectOptimum(solver, Problem, TestConsts, Optimum(Problem, TestConsts), "one sided stealing changed the result");
+	// only process 0 starts with work, the others get theirs from the rings
+	EXPECT_GT(OverAll(Stats(solver).Steals, MPI_SUM), 0) << "nobody stole from a ring";
+}
+
+TEST(MPIKnapsack, OneSidedBigSubproblems)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 48);
+	auto Problem = GeneratePaddedProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// every subproblem takes several slots and some of them wrap around the end of the ring,
+	// in the last ring no subproblem fits and all of them stay on process 0
+	BnB::Solver_MPI<BnB::Knapsack::Consts, PaddedParams, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::ONESIDED);
+	for (auto [slots, bytes] : {std::pair<int, int>{64, 1024}, {64, 300}, {2, 64}}) {
+		static_cast<BnB::MPI_Scheduler_OneSided<BnB::Knapsack::Consts, PaddedParams, int>*>(
+				solver.SetSchedulerParameters()->Eps(0))->RingSlots(slots)->SlotSize(bytes);
+		ExpectOptimum(solver, Problem, TestConsts, expected,
+		              std::to_string(slots) + " slots of " + std::to_string(bytes) + " bytes changed the result");
+		if (slots == 2) {
+			EXPECT_GT(OverAll(Stats(solver).KeptTooBig, MPI_SUM), 0) << "no subproblem was too big for the ring";
+			EXPECT_EQ(OverAll(Stats(solver).Steals, MPI_SUM), 0) << "a subproblem too big for the ring was stolen";
+		}
+	}
+}
+
+TEST(MPIKnapsack, WorkerOnlyTermination)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 13);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+	int expected = Optimum(Problem, TestConsts);
+
+	// the token has to see every package in flight, small packages and frequent checks make many of them
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::WORKER_ONLY);
+	static_cast<BnB::MPI_Scheduler_WorkerOnly<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0)->CommFrequency(2))->TermCheckFrequency(1);
+	int num;
+	MPI_Comm_size(MPI_COMM_WORLD, &num);
+	for (int i = 0; i < 3; i++) {
+		ExpectOptimum(solver, Problem, TestConsts, expected, "worker only search ended too early");
+		// work only leaves process 0 by stealing, without steals the token had nothing to count
+		if (num > 1)
+			EXPECT_GT(OverAll(Stats(solver).Steals, MPI_SUM), 0) << "no package moved between the processes";
+	}
+}
+
+TEST(MPIKnapsack, WorkerOnlyNodePool)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 19);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+	int expected = Optimum(Problem, TestConsts);
+
+	// with and without the shared memory pool, without it the processes of a node steal by message
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::WORKER_ONLY);
+	for (bool pool : {true, false}) {
+		static_cast<BnB::MPI_Scheduler_WorkerOnly<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+				solver.SetSchedulerParameters()->Eps(0))->TermCheckFrequency(1)->NodePool(pool);
+		ExpectOptimum(solver, Problem, TestConsts, expected, "node pool " + std::to_string(pool) + " changed the result");
+		// all processes of the test share a node
+		long long takes = OverAll(Stats(solver).PoolTakes, MPI_SUM);
+		if (pool) EXPECT_GT(takes, 0) << "nothing was taken from the node pool";
+		else EXPECT_EQ(takes, 0) << "the node pool was used while it was off";
+	}
+}
+
+TEST(MPIKnapsack, WorkerOnlyBigSubproblems)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 47);
+	auto Problem = GeneratePaddedProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// the subproblems take several slots of the default pool, a pool of two 16 byte slots is too small for them
+	// and the node steals them by message
+	BnB::Solver_MPI<BnB::Knapsack::Consts, PaddedParams, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::WORKER_ONLY);
+	for (int slots : {64, 2}) {
+		static_cast<BnB::MPI_Scheduler_WorkerOnly<BnB::Knapsack::Consts, PaddedParams, int>*>(
+				solver.SetSchedulerParameters()->Eps(0))->PoolSlots(slots)->PoolSlotSize(slots == 2 ? 16 : 1024);
+		ExpectOptimum(solver, Problem, TestConsts, expected, "pool of " + std::to_string(slots) + " slots changed the result");
+		if (slots == 2) {
+			EXPECT_GT(OverAll(Stats(solver).KeptTooBig, MPI_SUM), 0) << "no subproblem was too big for the pool";
+			EXPECT_EQ(OverAll(Stats(solver).PoolTakes, MPI_SUM), 0) << "a subproblem too big for the pool was taken from it";
+		}
+	}
+}
+
+TEST(MPIKnapsack, HierarchicalMaster)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 17);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	// the smallest groups give the most sub-masters, so work has to move between groups through the root.
+	// Several groups need 5 processes, ctest runs this test once more with that many
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::HIERARCHICAL);
+	auto scheduler = static_cast<BnB::MPI_Scheduler_Hierarchical<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0))->GroupSize(2);
+	ExpectOptimum(solver, Problem, TestConsts, Optimum(Problem, TestConsts), "sub-masters changed the result");
+
+	int num;
+	MPI_Comm_size(MPI_COMM_WORLD, &num);
+	if(Rank() == 0)
+	{
+		EXPECT_EQ(scheduler->Groups(), std::max(1, (num - 1) / 2));
+		if (num >= 5)
+			EXPECT_GT(scheduler->GroupsLent(), 0) << "no group got work from another group";
+	}
+}
+
+TEST(MPIKnapsack, HybridCommunicationThread)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 23);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+	int expected = Optimum(Problem, TestConsts);
+
+	// several compute threads share the queue while the communication thread gives work away
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::HYBRID);
+	static_cast<BnB::MPI_Scheduler_Hybrid<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0)->CommFrequency(2))->Threads(3);
+	int num;
+	MPI_Comm_size(MPI_COMM_WORLD, &num);
+	long long sent = 0;
+	for (int i = 0; i < 2; i++) {
+		ExpectOptimum(solver, Problem, TestConsts, expected, "hybrid search changed the result");
+		sent += OverAll(Stats(solver).PackagesSent, MPI_SUM);
+	}
+	// the master starts one worker, a second worker only gets work from the communication thread of another
+	if (num > 2)
+		EXPECT_GT(sent, 0) << "no worker gave work away";
+}
+
+TEST(MPIKnapsack, HybridOnOneThread)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10, 23);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// the search runs inside a parallel region and nested regions are off, so the runtime grants one thread
+	// instead of 4 and the communication thread has to compute on its own
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::HYBRID);
+	static_cast<BnB::MPI_Scheduler_Hybrid<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0))->Threads(3);
+	int levels = omp_get_max_active_levels();
+	omp_set_max_active_levels(1);
+#pragma omp parallel num_threads(2)
+	{
+#pragma omp master
+		ExpectOptimum(solver, Problem, TestConsts, expected, "hybrid search on one thread changed the result");
+	}
+	omp_set_max_active_levels(levels);
+	EXPECT_GT(OverAll(Stats(solver).Solved, MPI_SUM), 0) << "the communication thread did not compute";
+}
+
+TEST(MPIKnapsack, WorkingMaster)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 29);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+	int expected = Optimum(Problem, TestConsts);
+
+	// the master expands subproblems itself and is handed out to the workers as an idle process
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::HYBRID}) {
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0)->CommFrequency(2)->WorkingMaster(true);
+		ExpectOptimum(solver, Problem, TestConsts, expected, "working master changed the result");
+		if(Rank() == 0)
+			EXPECT_GT(Stats(solver).Solved, 0) << "the master did not expand anything";
+	}
+}
+
+TEST(MPIKnapsack, GlobalPool)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 31);
+	auto Problem = Slowed(BnB::Knapsack::GenerateToyProblem());
+	int expected = Optimum(Problem, TestConsts);
+
+	// a small pool fills up quickly, so workers are both told to feed it and to wait for it to drain.
+	// With an interval the packages grow with the latency, the ones for the pool must not
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	long long pooled = 0;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::HYBRID}) {
+		for (double interval : {0.0, 20.0}) {
+			solver.SetScheduler(type);
+			solver.SetSchedulerParameters()->Eps(0)->CommFrequency(2)->GlobalPool(4)->CommInterval(interval);
+			ExpectOptimum(solver, Problem, TestConsts, expected, "global pool changed the result");
+			pooled += Stats(solver).PackagesPooled;
+			if(Rank() == 0)
+				EXPECT_LE(Stats(solver).LargestPool, 4) << "the pool held more than its size";
+		}
+	}
+	if(Rank() == 0)
+		EXPECT_GT(pooled, 0) << "the pool was never fed";
+}
+
+TEST(MPIKnapsack, RampUp)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 37);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// every worker starts with its own share of the first subproblems, from the master or its own expansion
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::HYBRID}) {
+		for (auto ramp : {BnB::RampUp_Type::MASTER_BFS, BnB::RampUp_Type::RACING}) {
+			solver.SetScheduler(type);
+			solver.SetSchedulerParameters()->Eps(0)->RampUp(ramp, 3);
+			ExpectOptimum(solver, Problem, TestConsts, expected, "ramp-up changed the result");
+			long long share = Rank() == 0 ? LLONG_MAX : Stats(solver).RampUpShare;
+			EXPECT_GT(OverAll(share, MPI_MIN), 0) << "a worker started without a share of the ramp-up";
+		}
+	}
+}
+
+TEST(MPIKnapsack, SolutionOnAllRanks)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 41);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// the winner of the reduction broadcasts its solution, so every rank has to return the optimum
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::WORKER_ONLY}) {
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0)->SolutionOnAllRanks(true);
+		auto result = solver.Maximize(Problem, TestConsts);
+		EXPECT_EQ(Problem.GetContainedUpperBound(TestConsts, result), expected) << "rank " << Rank() << " misses the solution";
+	}
+}
+
+TEST(MPIKnapsack, ConstantsFromRoot)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 43);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// only the root knows the constants, the other ranks pass empty ones
+	BnB::Knapsack::Consts RootConsts;
+	if (Rank() == 0) RootConsts = TestConsts;
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetConstantsFromRoot(true);
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::WORKER_ONLY}) {
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0);
+		ExpectOptimum(solver, Problem, RootConsts, expected, "broadcast constants changed the result");
+	}
+}
+
+TEST(MPIKnapsack, SubCommunicator)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 44);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// the two halves solve at the same time with different schedulers, small runs keep one group.
+	// Every group root compares against the optimum, not only world rank 0
+	int num;
+	MPI_Comm_size(MPI_COMM_WORLD, &num);
+	int color = num >= 4 ? Rank() % 2 : 0;
+	MPI_Comm half;
+	MPI_Comm_split(MPI_COMM_WORLD, color, Rank(), &half);
+	{
+		BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> HalfSolver(half);
+		HalfSolver.SetScheduler(color == 0 ? BnB::MPI_Scheduler_Type::PRIORITY : BnB::MPI_Scheduler_Type::WORKER_ONLY);
+		HalfSolver.SetSchedulerParameters()->Eps(0);
+		ExpectOptimum(HalfSolver, Problem, TestConsts, expected, "group " + std::to_string(color) + " misses the solution", half);
+	}
+	MPI_Comm_free(&half);
+}
+
+TEST(MPIKnapsack, CommInterval)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 14, 45);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	// without an interval the pace stays at CommFrequency, a subproblem takes far less than a millisecond
+	// so with one the processes communicate less often
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::HYBRID,
+	                  BnB::MPI_Scheduler_Type::ONESIDED, BnB::MPI_Scheduler_Type::WORKER_ONLY}) {
+		for (double interval : {0.0, 20.0, 1000.0}) {
+			solver.SetScheduler(type);
+			solver.SetSchedulerParameters()->Eps(0)->CommFrequency(1)->CommInterval(interval);
+			ExpectOptimum(solver, Problem, TestConsts, expected, "adaptive pace changed the result");
+			int highest = OverAll(Stats(solver).HighestFrequency, MPI_MAX);
+			if (interval == 0.0) EXPECT_EQ(highest, 1) << "the pace changed without an interval";
+			if (interval == 1000.0) EXPECT_GT(highest, 1) << "the pace did not adapt to the interval";
+		}
+	}
+}
+
+TEST(MPIKnapsack, SolvesAgainAfterCancel)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 49);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	int expected = Optimum(Problem, TestConsts);
+
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::ONESIDED,
+	                  BnB::MPI_Scheduler_Type::WORKER_ONLY}) {
+		// the first solution found anywhere cancels the search on all processes, the cancel must not stop the next one
+		auto control = std::make_shared<BnB::Search_Control<BnB::Knapsack::Params, int>>();
+		control->OnImprovement([&control](int) { control->Cancel(); });
+		solver.AttachControl(control);
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0);
+		solver.Maximize(Problem, TestConsts);
+		control->OnImprovement(nullptr);
+		ExpectOptimum(solver, Problem, TestConsts, expected, "the cancel also stopped the next search");
+	}
+}
+
+TEST(MPIKnapsack, CheckpointRestart)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 16, 46);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	const std::string Path = "MPIKnapsackTest.checkpoint";
+
+	// the first solution found anywhere stops the search, its open subproblems go to the checkpoint
+	BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	auto control = std::make_shared<BnB::Search_Control<BnB::Knapsack::Params, int>>();
+	control->OnImprovement([&control](int) { control->Cancel(); });
+	solver.AttachControl(control);
+	solver.SetScheduler(BnB::MPI_Scheduler_Type::WORKER_ONLY);
+	auto scheduler = dynamic_cast<BnB::MPI_Scheduler_WorkerOnly<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+			solver.SetSchedulerParameters()->Eps(0));
+	scheduler->Checkpoint(Path);
+	solver.Maximize(Problem, TestConsts);
+
+	// the checkpoint holds the first solution and the open subproblems that were left
+	int id, num;
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &num);
+	{
+		BnB::MPI_Checkpoint<BnB::Knapsack::Params, int> checkpoint;
+		std::deque<BnB::Knapsack::Params> Open;
+		int Bound = 0;
+		BnB::Knapsack::Params Best;
+		long long Solved;
+		checkpoint.Read(Path, MPI_COMM_WORLD, MPI_Message_Encoder<BnB::Knapsack::Params>(), BnB::Goal::MAX, Open,
+		                Bound, Best, Solved);
+		EXPECT_GT(OverAll(Open.size(), MPI_SUM), 0) << "the checkpoint has no open subproblems";
+		EXPECT_GT(Bound, 0) << "the checkpoint has no solution";
+	}
+
+	// resumed by one process less if there are enough. It continues with the subproblems of the checkpoint, so
+	// the root is never split again
+	int color = num >= 3 && id == num - 1 ? 1 : 0;
+	MPI_Comm resumed;
+	MPI_Comm_split(MPI_COMM_WORLD, color, id, &resumed);
+	if(color == 0)
+	{
+		int RootSplits = 0;
+		auto Counted = Problem;
+		Counted.SplitSolution = [&](const BnB::Knapsack::Consts& c, const BnB::Knapsack::Params& p) {
+			if (std::get<0>(p).size() == std::get<0>(c).size()) RootSplits++; // the root holds all items
+			return Problem.SplitSolution(c, p);
+		};
+		BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> ResumedSolver(resumed);
+		ResumedSolver.SetScheduler(BnB::MPI_Scheduler_Type::WORKER_ONLY);
+		dynamic_cast<BnB::MPI_Scheduler_WorkerOnly<BnB::Knapsack::Consts, BnB::Knapsack::Params, int>*>(
+				ResumedSolver.SetSchedulerParameters()->Eps(0))->Restart(Path);
+		ExpectOptimum(ResumedSolver, Counted, TestConsts, Optimum(Problem, TestConsts), "restart misses the solution",
+		              resumed);
+		long long TotalRootSplits = OverAll(RootSplits, MPI_SUM, resumed);
+		if(id == 0)
+			EXPECT_EQ(TotalRootSplits, 0) << "restart started from the root instead of the checkpoint";
+	}
+	MPI_Comm_free(&resumed);
+	if(id == 0) std::remove(Path.c_str());
+}
+
+TEST(MPIKnapsack, BatchMatchesSingleSolves)
+{
+	// instances of different sizes, so that their optima differ and a result at the wrong index shows
+	std::vector<BnB::Knapsack::Consts> Instances;
+	for (int i = 0; i < 20; i++)
+		Instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 8 + i % 6, 52));
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	std::vector<int> expected;
+	BnB::Solver_Serial<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> single;
+	for (const auto& instance : Instances)
+		expected.push_back(Problem.GetContainedUpperBound(instance, single.Maximize(Problem, instance)));
+
+	// chunks of three, in every chunk the instances with 12 or more items use all threads of their process
+	BnB::Solver_MPI_Batch<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> batch;
+	batch.SetNumThreads(2);
+	batch.ChunkSize(3);
+	// the measure sees every instance this process solves
+	int SolvedHere = 0;
+	batch.GetLocalSolver().LargeInstances([&SolvedHere](const BnB::Knapsack::Consts& c) {
+		SolvedHere++;
+		return std::get<0>(c).size();
+	}, 12);
+	batch.GetLocalSolver().SetSchedulerParameters()->Eps(0);
+	std::vector<int> solved(Instances.size(), 0);
+	batch.Maximize(Problem, Instances.begin(), Instances.end(),
+	               [&](size_t i, const BnB::Knapsack::Params& solution) {
+		solved[i]++;
+		EXPECT_EQ(Problem.GetContainedUpperBound(Instances[i], solution), expected[i]) << "instance " << i;
+	});
+
+	// the results only arrive on process 0
+	int id;
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	if(id == 0)
+	{
+		for (size_t i = 0; i < Instances.size(); i++)
+			EXPECT_EQ(solved[i], 1) << "instance " << i << " was not reported exactly once";
+		EXPECT_GT(SolvedHere, 0) << "process 0 only handed out chunks";
+	}
+}
+
+TEST(MPIKnapsack, SessionMatchesSeparateSolves)
+{
+	std::vector<BnB::Knapsack::Consts> Instances;
+	for (int i = 0; i < 4; i++)
+		Instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 9 + i, 53 + i));
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	int id;
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	// the windows, rings and requests of one solve are reused by the next, they must start empty every time
+	for (auto type : {BnB::MPI_Scheduler_Type::PRIORITY, BnB::MPI_Scheduler_Type::ONESIDED,
+	                  BnB::MPI_Scheduler_Type::WORKER_ONLY}) {
+		BnB::Session<BnB::Solver_MPI, BnB::Knapsack::Consts, BnB::Knapsack::Params, int> session(Problem, BnB::Goal::MAX);
+		session.GetSolver().SetScheduler(type);
+		session.GetSolver().SetSchedulerParameters()->Eps(0)->SharedIncumbent(true);
+		for (int round = 0; round < 2; round++) {
+			for (const auto& instance : Instances) {
+				BnB::Solver_MPI<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> separate;
+				separate.SetScheduler(type);
+				separate.SetSchedulerParameters()->Eps(0);
+				auto expected = separate.Maximize(Problem, instance);
+				auto result = session.Solve(instance);
+				if(id == 0)
+				{
+					EXPECT_EQ(Problem.GetContainedUpperBound(instance, result),
+					          Problem.GetContainedUpperBound(instance, expected)) << "the session missed the optimum";
+				}
+			}
+		}
+		EXPECT_EQ(session.SolveCount(), 2 * Instances.size());
+	}
+}
+
+TEST(MPIKnapsack, FixedLayoutPackage)
+{
+	// subproblems without pointers are sent as one array of a derived datatype
+	using Params = std::tuple<int, double, float>;
+	std::vector<Params> package {{1, 2.5, 3.5f}, {-4, 1e300, 0.25f}, {7, 0.0, -1.0f}};
+
+	MPI_Message_Encoder<Params> encoder;
+	MPI_Buffer buffer;
+	encoder.Encode_Package(buffer, package);
+	encoder.Encode_Package(buffer, {});
+
+	std::vector<Params> received, empty {{0, 0.0, 0.0f}};
+	buffer.Receive(buffer.Size());
+	encoder.Decode_Package(buffer, received);
+	encoder.Decode_Package(buffer, empty);
+
+	EXPECT_EQ(received, package) << "derived datatype package is broken";
+	EXPECT_TRUE(empty.empty()) << "empty package is not empty";
+}
+
 int main(int argc, char* argv[])
 {	
     int result = 0;
 
-    if(MPI_Init(&argc, &argv) != MPI_SUCCESS)
+    // the hybrid scheduler computes on other threads while the calling thread communicates
+    int provided;
+    if(MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided) != MPI_SUCCESS)
 		std::cerr << "initialization of MPI failed" << std::endl;
     ::testing::InitGoogleTest(&argc, argv);
 	
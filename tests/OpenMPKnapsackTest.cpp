@@ -2,6 +2,11 @@
 #include "Knapsack.h"
 #include "Base.h"
 #include "BnB_OMP_Solver.h"
+#include "BnB_Portfolio_Solver.h"
+#include "BnB_Batch_Solver.h"
+#include "BnB_Session.h"
+#include <thread>
+#include <chrono>
 
 
 TEST(OMPKnapsack, someItemsFit)
@@ -62,6 +67,300 @@ TEST(OMPKnapsack, NoItemsFit)
 	EXPECT_EQ(cost,  0) <<  "Weight does not match";	
 }
 
+TEST(OMPKnapsack, PinnedWithReplicatedConstants)
+{
+	BnB::Knapsack::Consts TestConsts;
+	std::get<0>(TestConsts) = {3,3,3,3,3};
+	std::get<1>(TestConsts) = {10,2,10,4,10};
+	std::get<2>(TestConsts) = 10;
+
+	// the threads expand subproblems with the copy of their domain, never with the caller's constants
+	std::atomic<int> OriginalReads{0};
+	auto Toy = BnB::Knapsack::GenerateToyProblem();
+	auto Problem = Toy;
+	Problem.SplitSolution = [&](const BnB::Knapsack::Consts& c, const BnB::Knapsack::Params& p) {
+		if (&c == &TestConsts) OriginalReads++;
+		return Toy.SplitSolution(c, p);
+	};
+
+	for (auto type : {BnB::OMP_Scheduler_Type::TASKING, BnB::OMP_Scheduler_Type::QUEUE}) {
+		BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+		solver.SetNumThreads(4);
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Affinity(BnB::OMP_Affinity::SCATTER)->NumaDomains(2);
+
+		auto result = std::get<0>(solver.Maximize(Problem, TestConsts));
+		int cost = 0;
+		for(const auto& item : result)
+			cost += std::get<1>(TestConsts)[item];
+		EXPECT_EQ(cost,  30) <<  "Weight does not match";
+		EXPECT_EQ(OriginalReads, 0) << "a thread read the constants of the caller";
+	}
+}
+
+TEST(OMPKnapsack, ReplicasPerDomain)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 20, 3);
+	BnB::Problem_Consts_Replicas<BnB::Knapsack::Consts> replicas;
+	replicas.Replicate(TestConsts, 2, BnB::OMP_Affinity::SCATTER, 4);
+
+	// every domain has its own copy
+	EXPECT_NE(&replicas.Replica(0), &replicas.Replica(1)) << "the domains share their constants";
+	for (int d = 0; d < 2; d++) {
+		EXPECT_NE(&replicas.Replica(d), &TestConsts) << "domain " << d << " reads the original";
+		EXPECT_EQ(replicas.Replica(d), TestConsts) << "the copy of domain " << d << " differs";
+	}
+
+	// a thread gets the copy of the domain it runs on
+	std::atomic<int> WrongCopies{0};
+	BnB::ParallelRegion(BnB::OMP_Affinity::SCATTER, 4, [&]() {
+		if (&replicas.Local() != &replicas.Replica(BnB::DomainOfThread(BnB::OMP_Affinity::SCATTER, 2)))
+			WrongCopies++;
+	});
+	EXPECT_EQ(WrongCopies, 0) << "threads read the copy of another domain";
+
+	// a single domain needs no copy
+	replicas.Replicate(TestConsts, 1, BnB::OMP_Affinity::SCATTER, 4);
+	EXPECT_EQ(&replicas.Local(), &TestConsts) << "a single domain got a copy";
+}
+
+TEST(OMPKnapsack, ParallelRegionBindsThreads)
+{
+	// the runtime only pins threads to places it knows, ctest runs this with OMP_PLACES=threads
+	if (omp_get_num_places() == 0)
+		GTEST_SKIP() << "no places, set OMP_PLACES to check the binding";
+
+	std::pair<BnB::OMP_Affinity, omp_proc_bind_t> Bindings[] = {{BnB::OMP_Affinity::COMPACT, omp_proc_bind_close},
+	                                                            {BnB::OMP_Affinity::SCATTER, omp_proc_bind_spread}};
+	for (auto [affinity, expected] : Bindings) {
+		std::atomic<int> Wrong{0}, Threads{0};
+		BnB::ParallelRegion(affinity, 4, [&, expected = expected]() {
+			Threads++;
+			if (omp_get_proc_bind() != expected) Wrong++;
+		});
+		EXPECT_EQ(Threads, 4);
+		EXPECT_EQ(Wrong, 0) << "the region was not bound with " << expected;
+	}
+}
+
+TEST(OMPKnapsack, PortfolioRace)
+{
+	BnB::Solver_Portfolio<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.AddStrategy(BnB::TraversalMode::DFS, 0)->AddStrategy(BnB::TraversalMode::BFS, 0)->AddBestFirstStrategy(0);
+
+	BnB::Knapsack::Consts TestConsts;
+	std::get<0>(TestConsts) = {3,3,3,3,3};
+	std::get<1>(TestConsts) = {10,2,10,4,10};
+	std::get<2>(TestConsts) = 10;
+
+	auto result = std::get<0>(solver.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts));
+	int cost = 0;
+	for(const auto& item : result)
+		cost += std::get<1>(TestConsts)[item];
+	EXPECT_EQ(cost,  30) <<  "Weight does not match";
+	EXPECT_NE(solver.Winner(), -1) << "no strategy finished the search";
+}
+
+TEST(OMPKnapsack, PortfolioOnFewerThreads)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 5);
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+	BnB::Solver_Serial<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> single;
+	int expected = Problem.GetContainedUpperBound(TestConsts, single.Maximize(Problem, TestConsts));
+
+	// a nested region gets a single thread, so both strategies run one after the other on it. The approximate
+	// one ends first but only the exact one may end the race
+	BnB::Solver_Portfolio<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.AddStrategy(BnB::TraversalMode::DFS, 50)->AddStrategy(BnB::TraversalMode::DFS, 0);
+	int levels = omp_get_max_active_levels();
+	omp_set_max_active_levels(1);
+	int result = 0;
+	bool dynamic = false;
+#pragma omp parallel num_threads(2)
+	{
+#pragma omp master
+		{
+			omp_set_dynamic(1);
+			result = Problem.GetContainedUpperBound(TestConsts, solver.Maximize(Problem, TestConsts));
+			dynamic = omp_get_dynamic();
+		}
+	}
+	EXPECT_EQ(result, expected) << "the approximate strategy ended the race";
+	EXPECT_EQ(solver.Winner(), 1) << "the exact strategy did not run or did not win";
+	EXPECT_TRUE(dynamic) << "the dynamic setting of the caller was not restored";
+	omp_set_max_active_levels(levels);
+}
+
+TEST(OMPKnapsack, AsyncSolveReportsProgress)
+{
+	BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+	solver.SetNumThreads(2);
+
+	BnB::Knapsack::Consts TestConsts;
+	std::get<0>(TestConsts) = {3,3,3,3,3};
+	std::get<1>(TestConsts) = {10,2,10,4,10};
+	std::get<2>(TestConsts) = 10;
+
+	auto handle = solver.SolveAsync(BnB::Knapsack::GenerateToyProblem(), TestConsts, BnB::Goal::MAX);
+	auto result = std::get<0>(handle.Get());
+	int cost = 0;
+	for(const auto& item : result)
+		cost += std::get<1>(TestConsts)[item];
+	EXPECT_EQ(cost,  30) <<  "Weight does not match";
+	EXPECT_EQ(handle.Incumbent(), 30) << "incumbent does not match the solution";
+	EXPECT_TRUE(handle.IsDone());
+}
+
+TEST(OMPKnapsack, AsyncSolveCancels)
+{
+	for (auto type : {BnB::OMP_Scheduler_Type::TASKING, BnB::OMP_Scheduler_Type::QUEUE}) {
+		BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+		solver.SetNumThreads(2);
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0);
+
+		// the toy bounds are too weak to finish this in reasonable time
+		auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 1000}, 60, 7);
+		auto handle = solver.SolveAsync(BnB::Knapsack::GenerateToyProblem(), TestConsts, BnB::Goal::MAX);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		EXPECT_FALSE(handle.IsDone()) << "search ended before it was cancelled";
+
+		auto start = std::chrono::steady_clock::now();
+		handle.Cancel();
+		handle.Get();
+		auto waited = std::chrono::steady_clock::now() - start;
+		EXPECT_LT(waited, std::chrono::seconds(1)) << "cancel took too long";
+	}
+}
+
+TEST(OMPKnapsack, SolvesAgainAfterCancel)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 9);
+	BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> reference;
+	reference.SetSchedulerParameters()->Eps(0);
+	auto expected = reference.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts);
+
+	for (auto type : {BnB::OMP_Scheduler_Type::TASKING, BnB::OMP_Scheduler_Type::QUEUE}) {
+		BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+		solver.SetNumThreads(2);
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0);
+
+		// the first solution cancels the search, the cancel must not stop the next one
+		auto control = std::make_shared<BnB::Search_Control<BnB::Knapsack::Params, int>>();
+		control->OnImprovement([&control](int) { control->Cancel(); });
+		solver.AttachControl(control);
+		solver.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts);
+		control->OnImprovement(nullptr);
+		auto result = solver.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts);
+		EXPECT_EQ(std::get<2>(result), std::get<2>(expected)) << "the cancel also stopped the next search";
+	}
+}
+
+TEST(OMPKnapsack, LateCancelKeepsNextSearch)
+{
+	auto TestConsts = BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 12, 9);
+	BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> reference;
+	reference.SetSchedulerParameters()->Eps(0);
+	auto expected = reference.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts);
+
+	for (auto type : {BnB::OMP_Scheduler_Type::TASKING, BnB::OMP_Scheduler_Type::QUEUE}) {
+		BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+		solver.SetNumThreads(2);
+		solver.SetScheduler(type);
+		solver.SetSchedulerParameters()->Eps(0);
+
+		// the handle belongs to the finished search, the solver still uses its control for the next one
+		auto handle = solver.SolveAsync(BnB::Knapsack::GenerateToyProblem(), TestConsts, BnB::Goal::MAX);
+		handle.Get();
+		EXPECT_LE(handle.RootGap(), 1) << "the root estimate is far off";
+		handle.Cancel();
+		auto result = solver.Maximize(BnB::Knapsack::GenerateToyProblem(), TestConsts);
+		EXPECT_EQ(std::get<2>(result), std::get<2>(expected)) << "the late cancel stopped the next search";
+	}
+}
+
+TEST(OMPKnapsack, BatchMatchesSingleSolves)
+{
+	// instances of different sizes, so that their optima differ and a result at the wrong index shows
+	std::vector<BnB::Knapsack::Consts> Instances;
+	for (int i = 0; i < 12; i++)
+		Instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 8 + i % 6, 51));
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	std::vector<int> expected;
+	BnB::Solver_Serial<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> single;
+	for (const auto& instance : Instances)
+		expected.push_back(Problem.GetContainedUpperBound(instance, single.Maximize(Problem, instance)));
+
+	// the instances with 12 or more items go to the solver that uses all threads for one instance
+	BnB::Solver_Batch<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> batch;
+	batch.SetNumThreads(3);
+	batch.LargeInstances([](const BnB::Knapsack::Consts& c) { return std::get<0>(c).size(); }, 12);
+	batch.SetSchedulerParameters()->Eps(0);
+	std::vector<int> solved(Instances.size(), 0);
+	batch.Maximize(Problem, Instances.begin(), Instances.end(),
+	               [&](size_t i, const BnB::Knapsack::Params& solution) {
+		solved[i]++;
+		EXPECT_EQ(Problem.GetContainedUpperBound(Instances[i], solution), expected[i]) << "instance " << i;
+	});
+	for (size_t i = 0; i < Instances.size(); i++)
+		EXPECT_EQ(solved[i], 1) << "instance " << i << " was not reported exactly once";
+}
+
+TEST(OMPKnapsack, BatchForwardsParameters)
+{
+	std::vector<BnB::Knapsack::Consts> Instances;
+	for (int i = 0; i < 6; i++)
+		Instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 10 + i, 54));
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	// with a big eps the serial solver stops early, the small instances of the batch have to do the same
+	std::vector<int> expected;
+	BnB::Solver_Serial<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> single;
+	single.SetSchedulerParameters()->Eps(1000);
+	for (const auto& instance : Instances)
+		expected.push_back(Problem.GetContainedUpperBound(instance, single.Maximize(Problem, instance)));
+
+	BnB::Solver_Batch<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> batch;
+	batch.SetNumThreads(2);
+	batch.SetSchedulerParameters()->Eps(1000);
+	batch.Maximize(Problem, Instances.begin(), Instances.end(),
+	               [&](size_t i, const BnB::Knapsack::Params& solution) {
+		EXPECT_EQ(Problem.GetContainedUpperBound(Instances[i], solution), expected[i]) << "instance " << i;
+	});
+}
+
+TEST(OMPKnapsack, SessionMatchesSeparateSolves)
+{
+	std::vector<BnB::Knapsack::Consts> Instances;
+	for (int i = 0; i < 6; i++)
+		Instances.push_back(BnB::Knapsack::GenerateRandomProblemConstants({1, 100}, 8 + i, 53));
+	auto Problem = BnB::Knapsack::GenerateToyProblem();
+
+	for (auto type : {BnB::OMP_Scheduler_Type::TASKING, BnB::OMP_Scheduler_Type::QUEUE}) {
+		std::vector<int> expected;
+		for (const auto& instance : Instances) {
+			BnB::Solver_OMP<BnB::Knapsack::Consts, BnB::Knapsack::Params, int> solver;
+			solver.SetNumThreads(2);
+			solver.SetScheduler(type);
+			solver.SetSchedulerParameters()->Eps(0);
+			expected.push_back(Problem.GetContainedUpperBound(instance, solver.Maximize(Problem, instance)));
+		}
+
+		// every instance twice, the second round runs on whatever the first one left behind
+		BnB::Session<BnB::Solver_OMP, BnB::Knapsack::Consts, BnB::Knapsack::Params, int> session(Problem, BnB::Goal::MAX);
+		session.GetSolver().SetNumThreads(2);
+		session.GetSolver().SetScheduler(type);
+		session.GetSolver().SetSchedulerParameters()->Eps(0);
+		for (int round = 0; round < 2; round++)
+			for (size_t i = 0; i < Instances.size(); i++)
+				EXPECT_EQ(Problem.GetContainedUpperBound(Instances[i], session.Solve(Instances[i])), expected[i])
+					<< "instance " << i << " in round " << round;
+		EXPECT_EQ(session.SolveCount(), 2 * Instances.size());
+	}
+}
+
 int main(int argc, char* argv[])
 {
 	testing::InitGoogleTest(&argc, argv);